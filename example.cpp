@@ -69,7 +69,8 @@ int main() {
     {
         sleep_ms(2000);
 
-        // Print as much characters as the screen can fit
+        // Print as much characters as the screen can fit. The frame sends cleared and new rows at once, without white flash.
+        display->BeginFrame();
         display->ClearScreen();
         for(int i = 0; i < max_lines; ++i)  // iterate through all lines
         {
@@ -86,7 +87,7 @@ int main() {
             // Reset the s string
             s = "";
         }
-        display->RefreshScreen(0,DISPLAY_HEIGHT);
+        display->EndFrame();
 
 
         // If all characters already displayed, switch to next font
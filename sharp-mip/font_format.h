@@ -0,0 +1,416 @@
+#ifndef FONT_FORMAT_H
+#define FONT_FORMAT_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <array>
+
+/*
+ * Fonts are tables of bytes, 1 bit per pixel, leftmost pixel in MSB, white pixel = 1.
+ *
+ * ---RAW FONT---
+ *  [0]     width of a glyph in BYTES
+ *  [1]     height of a glyph in PIXELS
+ *  [2]     first character in the table
+ *  [3...]  glyphs, width * height bytes each, row after row
+ *
+ * ---COMPRESSED FONT---
+ * Most of glyph rows are blank or the same as the row above them, e.g. vertical strokes. Only rows which differ from the
+ * previous row are stored.
+ *  [0]     kCompressedFontFlag | width of a glyph in BYTES
+ *  [1]     height of a glyph in PIXELS
+ *  [2]     first character in the table
+ *  [3]     amount of characters in the table
+ *  [4...]  offset of every glyph from the first glyph, uint16_t little endian
+ *  [...]   glyphs: (height + 7) / 8 bytes of row bitmap, then the stored rows. Bit (row % 8) of byte (row / 8) of the bitmap is set
+ *          if the row is stored, otherwise the row is the same as the previous one. The row above the first one is white.
+ *
+ * ---PROPORTIONAL FONT---
+ * Every glyph has its own advance, the distance in PIXELS from its left edge to the left edge of the next glyph.
+ *  [0]     kProportionalFontFlag | width of the widest glyph in BYTES
+ *  [1]     height of a glyph in PIXELS
+ *  [2]     first character in the table
+ *  [3]     amount of characters in the table
+ *  [4]     amount of kerning pairs
+ *  [5...]  for every glyph: offset from the first glyph, uint16_t little endian, and advance in PIXELS
+ *  [...]   kerning pairs sorted by the left and then the right character: left character, right character and int8_t adjustment
+ *          of the advance of the left character in PIXELS, usually negative
+ *  [...]   glyphs: height rows of (advance + 7) / 8 bytes each. Pixels right of the advance are white.
+ */
+
+constexpr uint8_t kCompressedFontFlag{0b10000000};
+constexpr uint8_t kProportionalFontFlag{0b01000000};
+constexpr uint8_t kFontWidthMask{0b00111111};
+constexpr uint8_t kRawFontHeaderSize{3};
+constexpr uint8_t kCompressedFontHeaderSize{4};
+constexpr uint8_t kProportionalFontHeaderSize{5};
+constexpr uint8_t kProportionalGlyphEntrySize{3};
+constexpr uint8_t kKerningPairSize{3};
+
+/**
+ * @brief Checks if the font is stored in the compressed format.
+ *
+ */
+constexpr bool IsCompressedFont(const uint8_t font[])
+{
+    return (font[0] & kCompressedFontFlag) != 0;
+}
+
+/**
+ * @brief Checks if the font is stored in the proportional format.
+ *
+ */
+constexpr bool IsProportionalFont(const uint8_t font[])
+{
+    return (font[0] & kProportionalFontFlag) != 0;
+}
+
+/**
+ * @brief Returns width of a glyph in BYTES, for fonts in any format. For proportional fonts it is the width of the widest glyph.
+ *
+ */
+constexpr uint8_t FontWidthInBytes(const uint8_t font[])
+{
+    return font[0] & kFontWidthMask;
+}
+
+/**
+ * @brief Returns advance of the character of a proportional font in PIXELS.
+ *
+ */
+inline uint8_t ProportionalGlyphAdvance(const uint8_t font[], char character)
+{
+    int index = character - font[2];
+    return font[kProportionalFontHeaderSize + index*kProportionalGlyphEntrySize + 2];
+}
+
+/**
+ * @brief Returns rows of the character of a proportional font, (advance + 7) / 8 bytes each.
+ *
+ */
+inline const uint8_t* ProportionalGlyphRows(const uint8_t font[], char character)
+{
+    uint8_t amount_of_chars = font[3];
+    uint8_t amount_of_kerning_pairs = font[4];
+    int index = character - font[2];
+    const uint8_t* entry = &font[kProportionalFontHeaderSize + index*kProportionalGlyphEntrySize];
+    uint16_t offset = entry[0] | (entry[1] << 8);
+    return &font[kProportionalFontHeaderSize + amount_of_chars*kProportionalGlyphEntrySize 
+                 + amount_of_kerning_pairs*kKerningPairSize + offset];
+}
+
+/**
+ * @brief Finds the kerning pair of a proportional font with binary search.
+ *
+ * @return adjustment of the advance of the left character in PIXELS, 0 if the pair is not in the table.
+ */
+inline int8_t KerningAdjustment(const uint8_t font[], char left, char right)
+{
+    const uint8_t* pairs = &font[kProportionalFontHeaderSize + font[3]*kProportionalGlyphEntrySize];
+    const uint16_t key = (static_cast<uint8_t>(left) << 8) | static_cast<uint8_t>(right);
+    int first{0};
+    int last{font[4] - 1};
+    while(first <= last)
+    {
+        int middle = (first + last) / 2;
+        const uint8_t* pair = &pairs[middle*kKerningPairSize];
+        uint16_t pair_key = (pair[0] << 8) | pair[1];
+        if(pair_key == key)
+        {
+            return static_cast<int8_t>(pair[2]);
+        }
+        if(pair_key < key)
+        {
+            first = middle + 1;
+        }
+        else
+        {
+            last = middle - 1;
+        }
+    }
+    return 0;
+}
+
+/**
+ * @brief Reads rows of one glyph from top to bottom, for fonts in any format. Nothing is copied, rows are read from the font table.
+ *
+ */
+class GlyphReader
+{
+public:
+
+    /**
+     * @param font Table with font, raw or compressed.
+     * @param character character from the font.
+     */
+    GlyphReader(const uint8_t font[], char character)
+    : kWidthInBytes_{FontWidthInBytes(font)}
+    {
+        uint8_t char_height_in_pixels = font[1];
+        int index = character - font[2];
+        if(IsCompressedFont(font))
+        {
+            uint8_t amount_of_chars = font[3];
+            const uint8_t* offsets = &font[kCompressedFontHeaderSize];
+            uint16_t offset = offsets[2*index] | (offsets[2*index + 1] << 8);
+            row_bitmap_ = &font[kCompressedFontHeaderSize + 2*amount_of_chars + offset];
+            next_row_ = row_bitmap_ + (char_height_in_pixels + 7) / 8;
+        }
+        else
+        {
+            next_row_ = &font[kRawFontHeaderSize + index*kWidthInBytes_*char_height_in_pixels];
+        }
+    }
+
+    /**
+     * @brief Returns the next row of the glyph.
+     *
+     * @return pointer to width-in-bytes pixels of the row, or nullptr if the row is white.
+     */
+    const uint8_t* NextRow()
+    {
+        if(row_bitmap_ == nullptr || ((row_bitmap_[row_index_ / 8] >> (row_index_ % 8)) & 1))
+        {
+            row_ = next_row_;
+            next_row_ += kWidthInBytes_;
+        }
+        ++row_index_;
+        return row_;
+    }
+
+private:
+
+    const uint8_t kWidthInBytes_;
+    const uint8_t* row_bitmap_{nullptr};    // nullptr for raw fonts, every row is stored
+    const uint8_t* next_row_;
+    const uint8_t* row_{nullptr};
+    uint8_t row_index_{0};
+};
+
+/**
+ * @brief Checks if the row of a glyph of a raw font has to be stored in the compressed format.
+ *
+ */
+constexpr bool IsRowStored(const uint8_t font[], size_t glyph_index, size_t row)
+{
+    const size_t width = font[0];
+    const size_t glyph_start = kRawFontHeaderSize + glyph_index*width*font[1];
+    for(size_t i = 0; i < width; ++i)
+    {
+        uint8_t pixels = font[glyph_start + row*width + i];
+        uint8_t pixels_above = (row == 0) ? 0b11111111 : font[glyph_start + (row - 1)*width + i];
+        if(pixels != pixels_above)
+        {
+            return true;
+        }
+    }
+    return false;
+}
+
+/**
+ * @brief Computes size of the compressed version of a raw font. Used as the template argument of CompressFont().
+ *
+ */
+template <size_t kFontSize>
+constexpr size_t CompressedFontSize(const uint8_t (&font)[kFontSize])
+{
+    const size_t width = font[0];
+    const size_t height = font[1];
+    const size_t amount_of_chars = (kFontSize - kRawFontHeaderSize) / (width*height);
+    size_t size = kCompressedFontHeaderSize + 2*amount_of_chars;
+    for(size_t c = 0; c < amount_of_chars; ++c)
+    {
+        size += (height + 7) / 8;
+        for(size_t j = 0; j < height; ++j)
+        {
+            if(IsRowStored(font, c, j))
+            {
+                size += width;
+            }
+        }
+    }
+    return size;
+}
+
+/**
+ * @brief Converts a raw font to the compressed format at compile time. Only the compressed table is placed in flash
+ * if the raw one is not used anywhere else, e.g.
+ * constexpr auto kFont_16_20_Compressed = CompressFont<CompressedFontSize(kFont_16_20)>(kFont_16_20);
+ *
+ * @tparam kSize size of the compressed font, CompressedFontSize(font).
+ * @param font raw font, at most 255 characters, with glyphs up to 64 kB in total.
+ * @return compressed font, pass data() of it to the draw methods.
+ */
+template <size_t kSize, size_t kFontSize>
+constexpr std::array<uint8_t, kSize> CompressFont(const uint8_t (&font)[kFontSize])
+{
+    const size_t width = font[0];
+    const size_t height = font[1];
+    const size_t amount_of_chars = (kFontSize - kRawFontHeaderSize) / (width*height);
+    const size_t row_bitmap_size = (height + 7) / 8;
+
+    std::array<uint8_t, kSize> compressed{};
+    compressed[0] = kCompressedFontFlag | font[0];
+    compressed[1] = font[1];
+    compressed[2] = font[2];
+    compressed[3] = static_cast<uint8_t>(amount_of_chars);
+
+    const size_t glyphs_start = kCompressedFontHeaderSize + 2*amount_of_chars;
+    size_t position = glyphs_start;
+    for(size_t c = 0; c < amount_of_chars; ++c)
+    {
+        const size_t offset = position - glyphs_start;
+        compressed[kCompressedFontHeaderSize + 2*c] = static_cast<uint8_t>(offset);
+        compressed[kCompressedFontHeaderSize + 2*c + 1] = static_cast<uint8_t>(offset >> 8);
+
+        const size_t row_bitmap = position;
+        position += row_bitmap_size;
+        for(size_t j = 0; j < height; ++j)
+        {
+            if(IsRowStored(font, c, j))
+            {
+                compressed[row_bitmap + j / 8] |= 1 << (j % 8);
+                for(size_t i = 0; i < width; ++i)
+                {
+                    compressed[position++] = font[kRawFontHeaderSize + c*width*height + j*width + i];
+                }
+            }
+        }
+    }
+    return compressed;
+}
+
+/**
+ * @brief Checks if the pixel of a glyph of a raw font is black.
+ *
+ */
+constexpr bool IsPixelBlack(const uint8_t font[], size_t glyph_index, size_t row, size_t column)
+{
+    const size_t width = font[0];
+    const uint8_t pixels = font[kRawFontHeaderSize + glyph_index*width*font[1] + row*width + column / 8];
+    return ((pixels >> (7 - column % 8)) & 1) == 0;
+}
+
+/**
+ * @brief Finds the first and the last column of a glyph of a raw font with black pixels.
+ *
+ * @return false if the glyph is blank.
+ */
+constexpr bool FindInkColumns(const uint8_t font[], size_t glyph_index, size_t& first_column, size_t& last_column)
+{
+    const size_t width_in_pixels = font[0] * 8;
+    bool has_ink{false};
+    for(size_t i = 0; i < width_in_pixels; ++i)
+    {
+        for(size_t j = 0; j < font[1]; ++j)
+        {
+            if(IsPixelBlack(font, glyph_index, j, i))
+            {
+                if(!has_ink)
+                {
+                    first_column = i;
+                }
+                last_column = i;
+                has_ink = true;
+                break;
+            }
+        }
+    }
+    return has_ink;
+}
+
+/**
+ * @brief Returns advance of a glyph of a raw font converted by MakeProportionalFont(). Blank glyphs, e.g. space, are half of the cell wide.
+ *
+ */
+constexpr size_t ProportionalAdvance(const uint8_t font[], size_t glyph_index, uint8_t spacing)
+{
+    size_t first_column{0};
+    size_t last_column{0};
+    if(!FindInkColumns(font, glyph_index, first_column, last_column))
+    {
+        return font[0] * 4;
+    }
+    return last_column - first_column + 1 + spacing;
+}
+
+/**
+ * @brief Computes size of the proportional version of a raw font. Used as the template argument of MakeProportionalFont().
+ *
+ */
+template <size_t kFontSize>
+constexpr size_t ProportionalFontSize(const uint8_t (&font)[kFontSize], uint8_t spacing)
+{
+    const size_t amount_of_chars = (kFontSize - kRawFontHeaderSize) / (font[0]*font[1]);
+    size_t size = kProportionalFontHeaderSize + kProportionalGlyphEntrySize*amount_of_chars;
+    for(size_t c = 0; c < amount_of_chars; ++c)
+    {
+        size += (ProportionalAdvance(font, c, spacing) + 7) / 8 * font[1];
+    }
+    return size;
+}
+
+/**
+ * @brief Converts a fixed width raw font to the proportional format at compile time. Blank columns on both sides of every glyph
+ * are removed and spacing columns are added on the right side. The font has no kerning pairs, e.g.
+ * constexpr auto kFont_16_20_Proportional = MakeProportionalFont<ProportionalFontSize(kFont_16_20, 2)>(kFont_16_20, 2);
+ *
+ * @tparam kSize size of the proportional font, ProportionalFontSize(font, spacing).
+ * @param font raw font, at most 255 characters, with glyphs up to 64 kB in total.
+ * @param spacing distance between glyphs in PIXELS.
+ * @return proportional font, pass data() of it to the draw methods.
+ */
+template <size_t kSize, size_t kFontSize>
+constexpr std::array<uint8_t, kSize> MakeProportionalFont(const uint8_t (&font)[kFontSize], uint8_t spacing)
+{
+    const size_t height = font[1];
+    const size_t amount_of_chars = (kFontSize - kRawFontHeaderSize) / (font[0]*height);
+
+    // Spacing can make a glyph wider than the cell of the raw font
+    size_t widest_glyph_in_bytes{0};
+    for(size_t c = 0; c < amount_of_chars; ++c)
+    {
+        widest_glyph_in_bytes = std::max(widest_glyph_in_bytes, (ProportionalAdvance(font, c, spacing) + 7) / 8);
+    }
+
+    std::array<uint8_t, kSize> proportional{};
+    proportional[0] = kProportionalFontFlag | static_cast<uint8_t>(widest_glyph_in_bytes);
+    proportional[1] = font[1];
+    proportional[2] = font[2];
+    proportional[3] = static_cast<uint8_t>(amount_of_chars);
+    proportional[4] = 0;
+
+    const size_t glyphs_start = kProportionalFontHeaderSize + kProportionalGlyphEntrySize*amount_of_chars;
+    size_t position = glyphs_start;
+    for(size_t c = 0; c < amount_of_chars; ++c)
+    {
+        const size_t advance = ProportionalAdvance(font, c, spacing);
+        const size_t width_in_bytes = (advance + 7) / 8;
+        const size_t offset = position - glyphs_start;
+        proportional[kProportionalFontHeaderSize + kProportionalGlyphEntrySize*c] = static_cast<uint8_t>(offset);
+        proportional[kProportionalFontHeaderSize + kProportionalGlyphEntrySize*c + 1] = static_cast<uint8_t>(offset >> 8);
+        proportional[kProportionalFontHeaderSize + kProportionalGlyphEntrySize*c + 2] = static_cast<uint8_t>(advance);
+
+        size_t first_column{0};
+        size_t last_column{0};
+        const bool has_ink = FindInkColumns(font, c, first_column, last_column);
+        for(size_t j = 0; j < height; ++j)
+        {
+            for(size_t i = 0; i < width_in_bytes * 8; ++i)
+            {
+                const bool black = has_ink && i <= last_column - first_column && IsPixelBlack(font, c, j, first_column + i);
+                if(!black)
+                {
+                    proportional[position + i / 8] |= 0b10000000 >> (i % 8);
+                }
+            }
+            position += width_in_bytes;
+        }
+    }
+    return proportional;
+}
+
+
+#endif // FONT_FORMAT_H
@@ -6,7 +6,7 @@
 // FONT_16x20: (4px + 12px) x 20px
 // 4px - space between chars
 // 12px - width of a char
-const uint8_t kFont_16_20[] = {
+constexpr uint8_t kFont_16_20[] = {
     
     // ---FONT WIDTH x HEIGTH---
     // Width - number of BYTES used to represent width of char it is NOT the same as width of char in pixels
@@ -0,0 +1,11 @@
+#ifndef FONT_16x20_COMPRESSED_H
+#define FONT_16x20_COMPRESSED_H
+
+#include "font_16x20.h"
+#include "../font_format.h"
+
+// kFont_16_20 in the compressed format, use kFont_16_20_Compressed.data() in place of kFont_16_20.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_16_20_Compressed = CompressFont<CompressedFontSize(kFont_16_20)>(kFont_16_20);
+
+#endif // FONT_16x20_COMPRESSED_H
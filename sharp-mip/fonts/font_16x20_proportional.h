@@ -0,0 +1,11 @@
+#ifndef FONT_16x20_PROPORTIONAL_H
+#define FONT_16x20_PROPORTIONAL_H
+
+#include "font_16x20.h"
+#include "../font_format.h"
+
+// kFont_16_20 with proportional glyphs, 2px between glyphs, use kFont_16_20_Proportional.data() in place of kFont_16_20.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_16_20_Proportional = MakeProportionalFont<ProportionalFontSize(kFont_16_20, 2)>(kFont_16_20, 2);
+
+#endif // FONT_16x20_PROPORTIONAL_H
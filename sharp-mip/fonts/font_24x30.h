@@ -6,7 +6,7 @@
 // FONT_24x30: (6px + 18px) x 30px
 // 6px - space between chars
 // 18px - width of a char
-const uint8_t kFont_24_30[] = {
+constexpr uint8_t kFont_24_30[] = {
     
     // ---FONT WIDTH x HEIGTH---
     // Width - number of BYTES used to represent width of char it is NOT the same as width of char in pixels
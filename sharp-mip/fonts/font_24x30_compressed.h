@@ -0,0 +1,11 @@
+#ifndef FONT_24x30_COMPRESSED_H
+#define FONT_24x30_COMPRESSED_H
+
+#include "font_24x30.h"
+#include "../font_format.h"
+
+// kFont_24_30 in the compressed format, use kFont_24_30_Compressed.data() in place of kFont_24_30.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_24_30_Compressed = CompressFont<CompressedFontSize(kFont_24_30)>(kFont_24_30);
+
+#endif // FONT_24x30_COMPRESSED_H
@@ -0,0 +1,11 @@
+#ifndef FONT_24x30_PROPORTIONAL_H
+#define FONT_24x30_PROPORTIONAL_H
+
+#include "font_24x30.h"
+#include "../font_format.h"
+
+// kFont_24_30 with proportional glyphs, 3px between glyphs, use kFont_24_30_Proportional.data() in place of kFont_24_30.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_24_30_Proportional = MakeProportionalFont<ProportionalFontSize(kFont_24_30, 3)>(kFont_24_30, 3);
+
+#endif // FONT_24x30_PROPORTIONAL_H
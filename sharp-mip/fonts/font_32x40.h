@@ -6,7 +6,7 @@
 // FONT_32x40: (8px + 24px) x 40px
 // 8px - space between chars
 // 24px - width of a char
-const uint8_t kFont_32_40[] = {
+constexpr uint8_t kFont_32_40[] = {
     
     // ---FONT WIDTH x HEIGTH---
     // Width - number of BYTES used to represent width of char it is NOT the same as width of char in pixels
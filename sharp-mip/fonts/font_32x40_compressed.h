@@ -0,0 +1,11 @@
+#ifndef FONT_32x40_COMPRESSED_H
+#define FONT_32x40_COMPRESSED_H
+
+#include "font_32x40.h"
+#include "../font_format.h"
+
+// kFont_32_40 in the compressed format, use kFont_32_40_Compressed.data() in place of kFont_32_40.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_32_40_Compressed = CompressFont<CompressedFontSize(kFont_32_40)>(kFont_32_40);
+
+#endif // FONT_32x40_COMPRESSED_H
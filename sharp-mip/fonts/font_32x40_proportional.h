@@ -0,0 +1,11 @@
+#ifndef FONT_32x40_PROPORTIONAL_H
+#define FONT_32x40_PROPORTIONAL_H
+
+#include "font_32x40.h"
+#include "../font_format.h"
+
+// kFont_32_40 with proportional glyphs, 4px between glyphs, use kFont_32_40_Proportional.data() in place of kFont_32_40.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_32_40_Proportional = MakeProportionalFont<ProportionalFontSize(kFont_32_40, 4)>(kFont_32_40, 4);
+
+#endif // FONT_32x40_PROPORTIONAL_H
@@ -8,7 +8,7 @@
 // FONT_8x10: (2px + 6px) x 10px
 // 2px - space between chars
 // 6px - width of a char
-const uint8_t kFont_8_10[] = {
+constexpr uint8_t kFont_8_10[] = {
     
     // ---FONT WIDTH x HEIGTH---
     // Width - number of BYTES used to represent width of char it is NOT the same as width of char in pixels
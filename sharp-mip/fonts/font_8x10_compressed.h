@@ -0,0 +1,11 @@
+#ifndef FONT_8x10_COMPRESSED_H
+#define FONT_8x10_COMPRESSED_H
+
+#include "font_8x10.h"
+#include "../font_format.h"
+
+// kFont_8_10 in the compressed format, use kFont_8_10_Compressed.data() in place of kFont_8_10.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_8_10_Compressed = CompressFont<CompressedFontSize(kFont_8_10)>(kFont_8_10);
+
+#endif // FONT_8x10_COMPRESSED_H
@@ -0,0 +1,11 @@
+#ifndef FONT_8x10_PROPORTIONAL_H
+#define FONT_8x10_PROPORTIONAL_H
+
+#include "font_8x10.h"
+#include "../font_format.h"
+
+// kFont_8_10 with proportional glyphs, 1px between glyphs, use kFont_8_10_Proportional.data() in place of kFont_8_10.
+// The table is generated while this header is compiled, so include it only in files which draw with it.
+constexpr auto kFont_8_10_Proportional = MakeProportionalFont<ProportionalFontSize(kFont_8_10, 1)>(kFont_8_10, 1);
+
+#endif // FONT_8x10_PROPORTIONAL_H
@@ -0,0 +1,96 @@
+#ifndef GLYPH_BLITTER_H
+#define GLYPH_BLITTER_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+#include <cstring>
+
+/**
+ * @brief Copies glyphs of fixed-width fonts into the screen buffer, row by row. The width of a glyph is known at compile time,
+ * so every glyph row is copied with one fixed-size memcpy, which the compiler turns into the widest store the CPU supports
+ * at that alignment, without loops over bytes.
+ *
+ * @tparam kWidthInBytes width of a glyph in BYTES, 1 to 4.
+ */
+template <uint8_t kWidthInBytes>
+struct GlyphBlitter
+{
+    static_assert(kWidthInBytes >= 1 && kWidthInBytes <= 4, "GlyphBlitter supports glyphs 1 to 4 bytes wide");
+
+    /**
+     * @brief Overwrites one row of the glyph cell in the screen buffer.
+     *
+     * @param destination first byte of the row of the cell in the screen buffer.
+     * @param glyph_row kWidthInBytes bytes of the glyph row.
+     */
+    static void CopyRow(uint8_t* destination, const uint8_t* glyph_row)
+    {
+        std::memcpy(destination, glyph_row, kWidthInBytes);
+    }
+
+    /**
+     * @brief Merges one row of the glyph with the content of the screen buffer. Black pixels (0) of both are kept.
+     *
+     * @param destination first byte of the row of the cell in the screen buffer.
+     * @param glyph_row kWidthInBytes bytes of the glyph row.
+     */
+    static void AndRow(uint8_t* destination, const uint8_t* glyph_row)
+    {
+        uint32_t pixels{0};
+        uint32_t glyph_pixels{0};
+        std::memcpy(&pixels, destination, kWidthInBytes);
+        std::memcpy(&glyph_pixels, glyph_row, kWidthInBytes);
+        pixels &= glyph_pixels;
+        std::memcpy(destination, &pixels, kWidthInBytes);
+    }
+
+    /**
+     * @brief Fills one row of the glyph cell in the screen buffer with white pixels.
+     *
+     * @param destination first byte of the row of the cell in the screen buffer.
+     */
+    static void WhiteRow(uint8_t* destination)
+    {
+        std::memset(destination, 0b11111111, kWidthInBytes);
+    }
+
+    /**
+     * @brief Overwrites the glyph cell in the screen buffer with the glyph.
+     *
+     * @param destination first byte of the cell in the screen buffer.
+     * @param stride distance between rows of the screen buffer, in BYTES.
+     * @param glyph glyph rows, kWidthInBytes bytes per row.
+     * @param height number of rows to copy.
+     */
+    static void Copy(uint8_t* destination, size_t stride, const uint8_t* glyph, uint8_t height)
+    {
+        for(uint8_t j = 0; j < height; ++j)
+        {
+            CopyRow(destination, glyph);
+            destination += stride;
+            glyph += kWidthInBytes;
+        }
+    }
+
+    /**
+     * @brief Merges the glyph with the content of the screen buffer. Black pixels (0) of both are kept.
+     *
+     * @param destination first byte of the cell in the screen buffer.
+     * @param stride distance between rows of the screen buffer, in BYTES.
+     * @param glyph glyph rows, kWidthInBytes bytes per row.
+     * @param height number of rows to merge.
+     */
+    static void And(uint8_t* destination, size_t stride, const uint8_t* glyph, uint8_t height)
+    {
+        for(uint8_t j = 0; j < height; ++j)
+        {
+            AndRow(destination, glyph);
+            destination += stride;
+            glyph += kWidthInBytes;
+        }
+    }
+};
+
+
+#endif // GLYPH_BLITTER_H
@@ -0,0 +1,83 @@
+#include "glyph_cache.h"
+
+GlyphCache::GlyphCache(size_t amount_of_entries, size_t max_glyph_size)
+: kAmountOfEntries_{amount_of_entries}, kMaxGlyphSize_{max_glyph_size},
+  entries_{new Entry[amount_of_entries]{}}, glyphs_{new uint8_t[amount_of_entries * max_glyph_size]}
+{
+}
+
+GlyphCache::~GlyphCache()
+{
+    delete[] entries_;
+    delete[] glyphs_;
+}
+
+const uint8_t* GlyphCache::Get(const uint8_t font[], char character, uint8_t shift)
+{
+    ++use_counter_;
+    size_t oldest{0};
+    for(size_t i = 0; i < kAmountOfEntries_; ++i)
+    {
+        Entry& entry = entries_[i];
+        if(entry.font == font && entry.character == character && entry.shift == shift)
+        {
+            ++hits_;
+            entry.last_use = use_counter_;
+            return &glyphs_[i * kMaxGlyphSize_];
+        }
+        if(entry.last_use < entries_[oldest].last_use)
+        {
+            oldest = i;
+        }
+    }
+
+    ++misses_;
+    uint8_t width_in_bytes = FontWidthInBytes(font);
+    uint8_t height = font[1];
+    if(kAmountOfEntries_ == 0 || static_cast<size_t>(width_in_bytes + 1) * height > kMaxGlyphSize_)
+    {
+        return nullptr;
+    }
+    GlyphReader glyph(font, character);
+    uint8_t* destination = &glyphs_[oldest * kMaxGlyphSize_];
+    ShiftGlyph(destination, glyph, width_in_bytes, height, shift);
+    entries_[oldest] = Entry{font, character, shift, use_counter_};
+    return destination;
+}
+
+void GlyphCache::Clear()
+{
+    for(size_t i = 0; i < kAmountOfEntries_; ++i)
+    {
+        entries_[i] = Entry{};
+    }
+}
+
+void GlyphCache::ResetCounters()
+{
+    hits_ = 0;
+    misses_ = 0;
+}
+
+
+
+/********** PRIVATE **********/
+
+void GlyphCache::ShiftGlyph(uint8_t* destination, GlyphReader& glyph, uint8_t width_in_bytes, uint8_t height, uint8_t shift)
+{
+    // Pixels shifted in from outside of the cell are white
+    constexpr uint8_t kWhite{0b11111111};
+    for(uint8_t j = 0; j < height; ++j)
+    {
+        const uint8_t* glyph_row = glyph.NextRow();
+        uint8_t previous{kWhite};
+        for(uint8_t i = 0; i < width_in_bytes; ++i)
+        {
+            uint8_t pixels = (glyph_row != nullptr) ? glyph_row[i] : kWhite;
+            destination[i] = (previous << (8 - shift)) | (pixels >> shift);
+            previous = pixels;
+        }
+        destination[width_in_bytes] = (previous << (8 - shift)) | (kWhite >> shift);
+        destination += width_in_bytes + 1;
+    }
+}
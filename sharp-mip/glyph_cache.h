@@ -0,0 +1,92 @@
+#ifndef GLYPH_CACHE_H
+#define GLYPH_CACHE_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+#include "font_format.h"
+
+/**
+ * @brief Bounded cache of glyphs shifted right by 1-7 pixels, used by SharpMipDisplay::DrawLineOfTextAtPixel() with compressed fonts.
+ * Every entry holds one glyph of one font at one sub-byte offset. When the cache is full, the least recently used entry is replaced.
+ *
+ * A shifted glyph row is one byte wider than the glyph. Pixels outside of the glyph cell are white (1), so the shifted row
+ * can be merged with the screen buffer without shifting or masking the glyph again.
+ *
+ */
+class GlyphCache
+{
+public:
+
+    /**
+     * @brief Allocates the cache. RAM used for glyphs is amount_of_entries * max_glyph_size bytes.
+     *
+     * @param amount_of_entries maximal number of shifted glyphs kept in the cache.
+     * @param max_glyph_size size of the biggest cached glyph in BYTES, (font width in bytes + 1) * font height.
+     * Glyphs of bigger fonts are not cached, e.g. 50 for 8x10 font, 60 for 16x20, 120 for 24x30, 200 for 32x40.
+     */
+    GlyphCache(size_t amount_of_entries, size_t max_glyph_size);
+    ~GlyphCache();
+
+    GlyphCache(const GlyphCache&) = delete;
+    GlyphCache& operator=(const GlyphCache&) = delete;
+
+    /**
+     * @brief Returns glyph of the character shifted right by shift pixels. On a miss the glyph is shifted and stored in place
+     * of the least recently used entry.
+     *
+     * @param font Table with font, the same as for DrawLineOfText().
+     * @param character character from the font.
+     * @param shift offset in PIXELS, 1 to 7.
+     * @return rows of the shifted glyph, (font width in bytes + 1) bytes per row, or nullptr if the glyph does not fit into an entry.
+     */
+    const uint8_t* Get(const uint8_t font[], char character, uint8_t shift);
+
+    /**
+     * @brief Removes all glyphs from the cache, e.g. when a font in RAM was changed. Counters are not reset.
+     *
+     */
+    void Clear();
+
+    /**
+     * @brief Number of calls of Get() which found the glyph in the cache.
+     *
+     */
+    uint32_t GetHits() const { return hits_; }
+
+    /**
+     * @brief Number of calls of Get() which had to shift the glyph, or could not cache it.
+     *
+     */
+    uint32_t GetMisses() const { return misses_; }
+
+    /**
+     * @brief Sets hit and miss counters to 0.
+     *
+     */
+    void ResetCounters();
+
+private:
+
+    struct Entry
+    {
+        const uint8_t* font;    // nullptr if the entry is empty
+        char character;
+        uint8_t shift;
+        uint32_t last_use;
+    };
+
+    static void ShiftGlyph(uint8_t* destination, GlyphReader& glyph, uint8_t width_in_bytes, uint8_t height, uint8_t shift);
+
+    const size_t kAmountOfEntries_;
+    const size_t kMaxGlyphSize_;
+    Entry* entries_;
+    uint8_t* glyphs_;           // kMaxGlyphSize_ bytes for every entry
+    uint32_t use_counter_{0};
+    uint32_t hits_{0};
+    uint32_t misses_{0};
+};
+
+
+#endif // GLYPH_CACHE_H
@@ -0,0 +1,78 @@
+#include "rp2040_spi_dma.h"
+
+Rp2040SpiDma* Rp2040SpiDma::instances_[NUM_DMA_CHANNELS]{};
+
+Rp2040SpiDma::Rp2040SpiDma(spi_inst_t* spi)
+: kSPI_{spi}, kDmaChannel_{static_cast<uint>(dma_claim_unused_channel(true))}
+{
+    dma_channel_config config = dma_channel_get_default_config(kDmaChannel_);
+    channel_config_set_transfer_data_size(&config, DMA_SIZE_8);
+    channel_config_set_read_increment(&config, true);
+    channel_config_set_write_increment(&config, false);
+    channel_config_set_dreq(&config, spi_get_dreq(kSPI_, true));
+    dma_channel_configure(kDmaChannel_, &config, &spi_get_hw(kSPI_)->dr, nullptr, 0, false);
+
+    instances_[kDmaChannel_] = this;
+    dma_channel_set_irq0_enabled(kDmaChannel_, true);
+    irq_add_shared_handler(DMA_IRQ_0, &Rp2040SpiDma::HandleDmaIrq, PICO_SHARED_IRQ_HANDLER_DEFAULT_ORDER_PRIORITY);
+    irq_set_enabled(DMA_IRQ_0, true);
+}
+
+Rp2040SpiDma::~Rp2040SpiDma()
+{
+    dma_channel_set_irq0_enabled(kDmaChannel_, false);
+    dma_channel_abort(kDmaChannel_);
+    irq_remove_handler(DMA_IRQ_0, &Rp2040SpiDma::HandleDmaIrq);
+    instances_[kDmaChannel_] = nullptr;
+    dma_channel_unclaim(kDmaChannel_);
+}
+
+void Rp2040SpiDma::StartTransfer(const Segment segments[], size_t amount_of_segments)
+{
+    segments_ = segments;
+    amount_of_segments_ = amount_of_segments;
+    next_segment_ = 1;
+    dma_channel_transfer_from_buffer_now(kDmaChannel_, segments_[0].data, segments_[0].length);
+}
+
+
+
+/********** PRIVATE **********/
+
+void Rp2040SpiDma::HandleDmaIrq()
+{
+    for(uint i = 0; i < NUM_DMA_CHANNELS; ++i)
+    {
+        if(instances_[i] != nullptr && dma_channel_get_irq0_status(i))
+        {
+            dma_channel_acknowledge_irq0(i);
+            instances_[i]->OnDmaComplete();
+        }
+    }
+}
+
+void Rp2040SpiDma::OnDmaComplete()
+{
+    if(next_segment_ < amount_of_segments_)
+    {
+        // CS stays asserted, SPI continues with the next segment
+        const Segment& segment = segments_[next_segment_];
+        ++next_segment_;
+        dma_channel_transfer_from_buffer_now(kDmaChannel_, segment.data, segment.length);
+        return;
+    }
+
+    // DMA is done when the last byte is in TX FIFO, wait until it is shifted out
+    while(spi_is_busy(kSPI_))
+    {
+        tight_loop_contents();
+    }
+    // Nothing reads RX FIFO during the transfer, drain it and clear the overrun flag
+    while(spi_is_readable(kSPI_))
+    {
+        (void)spi_get_hw(kSPI_)->dr;
+    }
+    spi_get_hw(kSPI_)->icr = SPI_SSPICR_RORIC_BITS;
+
+    TransferComplete();
+}
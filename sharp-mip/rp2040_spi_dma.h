@@ -0,0 +1,45 @@
+#ifndef RP2040_SPI_DMA_H
+#define RP2040_SPI_DMA_H
+
+
+#include "hardware/spi.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+#include "spi_dma.h"
+
+/**
+ * @brief Sends buffers to SPI TX FIFO with a RP2040 DMA channel, paced by SPI DREQ. Completion is reported from DMA_IRQ_0.
+ * Next segment of a transfer is started from the interrupt of the previous one.
+ *
+ */
+class Rp2040SpiDma : public SpiDma
+{
+public:
+
+    /**
+     * @brief Claims a free DMA channel and installs shared handler of DMA_IRQ_0.
+     *
+     * @param spi SPI instance used by the display. It has to be initialized before the first transfer.
+     */
+    explicit Rp2040SpiDma(spi_inst_t* spi);
+    ~Rp2040SpiDma() override;
+
+    void StartTransfer(const Segment segments[], size_t amount_of_segments) override;
+
+private:
+
+    static void HandleDmaIrq();
+    void OnDmaComplete();
+
+    static Rp2040SpiDma* instances_[NUM_DMA_CHANNELS];
+
+    spi_inst_t* kSPI_;
+    const uint kDmaChannel_;
+    const Segment* segments_{nullptr};
+    size_t amount_of_segments_{0};
+    size_t next_segment_{0};
+};
+
+
+#endif // RP2040_SPI_DMA_H
@@ -1,280 +1,2449 @@
 #include "sharp_mip_display.h"
 
-SharpMipDisplay::SharpMipDisplay(uint16_t width, uint16_t height, spi_inst_t* spi, uint display_cs_pin)
-: Display(width, height), kDisplaySpiCsPin_{display_cs_pin}, kSPI_{spi}
+#include <array>
+
+static constexpr std::array<uint8_t, 256> MakeBitReversalTable()
+{
+    std::array<uint8_t, 256> table{};
+    for(size_t i = 0; i < table.size(); ++i)
+    {
+        uint8_t reversed{0};
+        for(size_t bit = 0; bit < 8; ++bit)
+        {
+            if(i & (1U << bit))
+            {
+                reversed |= 0b10000000 >> bit;
+            }
+        }
+        table[i] = reversed;
+    }
+    return table;
+}
+
+static constexpr std::array<uint8_t, 256> kBitReversalTable = MakeBitReversalTable();
+static_assert(kBitReversalTable[0b00000001] == 0b10000000 && kBitReversalTable[0b10100000] == 0b00000101, "Wrong bit reversal table");
+
+// Pixel bytes accessed as 32-bit words, allowed to alias the bytes of the screen buffer
+typedef uint32_t __attribute__((__may_alias__)) PixelWord;
+
+static inline void ApplyMask(uint8_t& pixels, uint8_t mask, SharpMipDisplay::PixelOp op)
+{
+    switch(op)
+    {
+    case SharpMipDisplay::PixelOp::kSet:
+        pixels &= ~mask;
+        break;
+    case SharpMipDisplay::PixelOp::kClear:
+        pixels |= mask;
+        break;
+    case SharpMipDisplay::PixelOp::kInvert:
+        pixels ^= mask;
+        break;
+    }
+}
+
+// Applies the operation to all pixels of bytes from first to last (excluded)
+static void ApplyToBytes(uint8_t* first, uint8_t* last, SharpMipDisplay::PixelOp op)
+{
+    // Single bytes up to a word boundary, then whole words, then the remaining bytes
+    while(first < last && (reinterpret_cast<uintptr_t>(first) & 3) != 0)
+    {
+        ApplyMask(*first++, 0b11111111, op);
+    }
+    PixelWord* word = reinterpret_cast<PixelWord*>(first);
+    PixelWord* const last_word = word + (last - first) / 4;
+    switch(op)
+    {
+    case SharpMipDisplay::PixelOp::kSet:
+        for(; word < last_word; ++word)
+        {
+            *word = 0;
+        }
+        break;
+    case SharpMipDisplay::PixelOp::kClear:
+        for(; word < last_word; ++word)
+        {
+            *word = 0xFFFFFFFF;
+        }
+        break;
+    case SharpMipDisplay::PixelOp::kInvert:
+        for(; word < last_word; ++word)
+        {
+            *word ^= 0xFFFFFFFF;
+        }
+        break;
+    }
+    first = reinterpret_cast<uint8_t*>(last_word);
+    while(first < last)
+    {
+        ApplyMask(*first++, 0b11111111, op);
+    }
+}
+
+static inline uint32_t ApplyRasterOp(uint32_t pixels, uint32_t source, uint32_t mask, SharpMipDisplay::RasterOp op)
+{
+    switch(op)
+    {
+    case SharpMipDisplay::RasterOp::kCopy:
+        return (pixels & ~mask) | (source & mask);
+    case SharpMipDisplay::RasterOp::kAnd:
+        return pixels & (source | ~mask);
+    case SharpMipDisplay::RasterOp::kOr:
+        return pixels | (source & mask);
+    case SharpMipDisplay::RasterOp::kXor:
+        return pixels ^ (source & mask);
+    case SharpMipDisplay::RasterOp::kAndNot:
+        return pixels & ~(source & mask);
+    }
+    return pixels;
+}
+
+// Pixels from first to last, both included, relative to the center of a shape
+struct Span
+{
+    int32_t first;
+    int32_t last;
+};
+
+// Wider than any screen, for spans which are not limited on one side
+static constexpr int32_t kUnlimited{1 << 24};
+
+// Integer square root, rounded down. 64 bit values are only used for lengths of lines, they are slow on the M0+.
+template <typename Unsigned>
+static Unsigned SquareRoot(Unsigned value)
+{
+    Unsigned root = 0;
+    Unsigned bit = static_cast<Unsigned>(1) << (sizeof(Unsigned) * 8 - 2);
+    while(bit > value)
+    {
+        bit >>= 2;
+    }
+    while(bit != 0)
+    {
+        if(value >= root + bit)
+        {
+            value -= root + bit;
+            root = (root >> 1) + bit;
+        }
+        else
+        {
+            root >>= 1;
+        }
+        bit >>= 2;
+    }
+    return root;
+}
+
+static int64_t FloorDiv(int64_t numerator, int64_t denominator)
+{
+    int64_t quotient = numerator / denominator;
+    if((numerator % denominator != 0) && ((numerator < 0) != (denominator < 0)))
+    {
+        --quotient;
+    }
+    return quotient;
+}
+
+static int64_t CeilDiv(int64_t numerator, int64_t denominator)
+{
+    return -FloorDiv(-numerator, denominator);
+}
+
+static int64_t RoundDiv(int64_t numerator, int64_t denominator)
+{
+    return FloorDiv(2 * numerator + denominator, 2 * denominator);
+}
+
+// sin() of 0 to 90 degrees in Q14, there is no FPU on the M0+
+static constexpr int16_t kSineQ14[91] = {
+    0, 286, 572, 857, 1143, 1428, 1713, 1997, 2280, 2563,
+    2845, 3126, 3406, 3686, 3964, 4240, 4516, 4790, 5063, 5334,
+    5604, 5872, 6138, 6402, 6664, 6924, 7182, 7438, 7692, 7943,
+    8192, 8438, 8682, 8923, 9162, 9397, 9630, 9860, 10087, 10311,
+    10531, 10749, 10963, 11174, 11381, 11585, 11786, 11982, 12176, 12365,
+    12551, 12733, 12911, 13085, 13255, 13421, 13583, 13741, 13894, 14044,
+    14189, 14330, 14466, 14598, 14726, 14849, 14968, 15082, 15191, 15296,
+    15396, 15491, 15582, 15668, 15749, 15826, 15897, 15964, 16026, 16083,
+    16135, 16182, 16225, 16262, 16294, 16322, 16344, 16362, 16374, 16382,
+    16384
+};
+
+static int32_t SineQ14(int32_t degrees)
+{
+    degrees %= 360;
+    if(degrees < 0)
+    {
+        degrees += 360;
+    }
+    if(degrees <= 90)
+    {
+        return kSineQ14[degrees];
+    }
+    if(degrees <= 180)
+    {
+        return kSineQ14[180 - degrees];
+    }
+    if(degrees <= 270)
+    {
+        return -kSineQ14[degrees - 180];
+    }
+    return -kSineQ14[360 - degrees];
+}
+
+static int32_t CosineQ14(int32_t degrees)
+{
+    return SineQ14(degrees + 90);
+}
+
+// Largest x for which pixel (x, dy) is inside the ellipse, -1 if row dy is outside of it.
+// Radii are enlarged by half a pixel, (a + 0.5)^2 ~ a^2 + a, so the top and bottom rows are flat like with the midpoint algorithm.
+static int32_t EllipseHalfWidth(uint32_t radius_x, uint32_t radius_y, int32_t dy)
+{
+    const uint64_t rx2 = static_cast<uint64_t>(radius_x) * (radius_x + 1);
+    const uint64_t ry2 = static_cast<uint64_t>(radius_y) * (radius_y + 1);
+    const uint64_t dy2 = static_cast<uint64_t>(static_cast<int64_t>(dy) * dy);
+    if(dy2 > ry2)
+    {
+        return -1;
+    }
+    if(ry2 == 0)
+    {
+        return radius_x;
+    }
+    return SquareRoot(static_cast<uint32_t>(rx2 * (ry2 - dy2) / ry2));
+}
+
+// Pixels x of a row for which a * x + b >= 0
+static Span HalfPlaneSpan(int32_t a, int32_t b)
+{
+    if(a > 0)
+    {
+        return Span{static_cast<int32_t>(CeilDiv(-b, a)), kUnlimited};
+    }
+    if(a < 0)
+    {
+        return Span{-kUnlimited, static_cast<int32_t>(FloorDiv(b, -a))};
+    }
+    return (b >= 0) ? Span{-kUnlimited, kUnlimited} : Span{1, 0};
+}
+
+SharpMipDisplay::SharpMipDisplay(uint16_t width, uint16_t height, spi_inst_t* spi, uint display_cs_pin, BufferLayout layout)
+: SharpMipDisplay(width, height, spi, display_cs_pin, layout, nullptr)
+{
+}
+
+SharpMipDisplay::SharpMipDisplay(uint16_t width, uint16_t height, spi_inst_t* spi, uint display_cs_pin, BufferLayout layout, uint8_t* screen_buffer,
+                                 uint8_t* packet_buffer, SpiDma::Segment* segments)
+: Display(width, height), kDisplaySpiCsPin_{display_cs_pin}, kSPI_{spi}, kLayout_{layout},
+  screen_buffer_{(screen_buffer != nullptr) ? screen_buffer : new uint8_t[kRowStride_ * kScreenHeight_]{}},
+  kPrimaryBuffer_{screen_buffer_}, kOwnsPrimaryBuffer_{screen_buffer == nullptr}, kPacketStorage_{packet_buffer},
+  transfer_segments_{(segments != nullptr) ? segments : new SpiDma::Segment[(kLayout_ == BufferLayout::kWire) ? (kScreenHeight_ + 1) / 2 + 2 : 1]},
+  kOwnsTransferSegments_{segments == nullptr}
 {
     // Set Chip Select pin used by SPI 
     gpio_init(kDisplaySpiCsPin_);
     gpio_set_dir(kDisplaySpiCsPin_, GPIO_OUT);
     gpio_put(kDisplaySpiCsPin_, 0);  // this display is low on inactive
-    sleep_ms(10);
+    cs_low_time_us_ = time_us_32();
 
     // Initialize buffer with white pixels
-    for(std::size_t i = 0; i < (kScreenHeight_ * kScreenWidthInWords_); ++i)
+    for(std::size_t i = 0; i < kScreenHeight_; ++i)
     {
-        screen_buffer_[i] = 0xFF;
+        std::fill(RowPointer(i), RowPointer(i) + kScreenWidthInWords_, 0xFF);
+        if(kLayout_ == BufferLayout::kWire)
+        {
+            screen_buffer_[i * kRowStride_] = SwapBigToLittleEndian(i);     //line address
+            screen_buffer_[i * kRowStride_ + kRowStride_ - 1] = 0b00000000;  //end line trailer
+        }
     }
 }
 
-// SharpMipDisplay::~SharpMipDisplay()
-// {
-//     // kSPI_ = nullptr;
-//     // delete kSPI_;
-//     // screen_buffer_ = nullptr;
-//     // delete screen_buffer_;
-//     // for (int i = 0; i < kScreenHeight_; i++) {
-//     //     delete[] screen_buffer_[i];
-//     // }
-//     // delete[] screen_buffer_;
-// }
+SharpMipDisplay::~SharpMipDisplay()
+{
+    // The VCOM timer is stopped first, so it can not post another transfer after WaitIdle()
+    DisableHardwareVcom();
+    WaitIdle();
+    if(pipeline_queue_ != nullptr)
+    {
+        // Core 1 waits for the next job of this display forever
+        multicore_reset_core1();
+        delete pipeline_queue_;
+        pipeline_queue_ = nullptr;
+    }
+    // Releases the engine and frees the packet buffer
+    EnableAsyncRefresh(nullptr);
+    // Frees the second buffer, whichever of screen_buffer_ and front_buffer_ it is now
+    EnableDoubleBuffering(false);
+    if(kOwnsPrimaryBuffer_)
+    {
+        delete[] kPrimaryBuffer_;
+    }
+    delete[] shadow_buffer_;
+    if(kOwnsTransferSegments_)
+    {
+        delete[] transfer_segments_;
+    }
+    spin_lock_unclaim(spin_lock_get_num(bus_lock_));
+}
 
 
 void SharpMipDisplay::DrawLineOfText(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
 {
     // printf("--SharpMipDisplay::DrawLineOfText : new_string = %s \n", new_string.c_str());
 
-    if(mode == Mode::kReplace)
+    // Select the kernel once per string
+    if(IsProportionalFont(font))
     {
-        DrawLineOfTextReplace(x, y, new_string, font);
+        DrawLineOfTextProportional(x * 8, y, new_string, font, mode);
+        MarkRowsDirty(y, y + font[1]);
+        return;
     }
-    else if(mode == Mode::kMix)
+    if(IsCompressedFont(font))
     {
-        DrawLineOfTextMix(x, y, new_string, font);
+        switch(FontWidthInBytes(font))
+        {
+        case 1:
+            DrawLineOfTextCompressed<1>(x, y, new_string, font, mode);
+            break;
+        case 2:
+            DrawLineOfTextCompressed<2>(x, y, new_string, font, mode);
+            break;
+        case 3:
+            DrawLineOfTextCompressed<3>(x, y, new_string, font, mode);
+            break;
+        case 4:
+            DrawLineOfTextCompressed<4>(x, y, new_string, font, mode);
+            break;
+        default:
+            DrawLineOfTextGeneric(x, y, new_string, font, mode);
+            break;
+        }
+        MarkRowsDirty(y, y + font[1]);
+        return;
     }
-    else
+
+    switch(font[0])
+    {
+    case 1:
+        DrawLineOfTextFixed<1>(x, y, new_string, font, mode);
+        break;
+    case 2:
+        DrawLineOfTextFixed<2>(x, y, new_string, font, mode);
+        break;
+    case 3:
+        DrawLineOfTextFixed<3>(x, y, new_string, font, mode);
+        break;
+    case 4:
+        DrawLineOfTextFixed<4>(x, y, new_string, font, mode);
+        break;
+    default:
+        DrawLineOfTextGeneric(x, y, new_string, font, mode);
+        break;
+    }
+    MarkRowsDirty(y, y + font[1]);
+}
+
+void SharpMipDisplay::DrawLineOfTextAtPixel(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
+{
+    if(IsProportionalFont(font))
+    {
+        DrawLineOfTextProportional(x, y, new_string, font, mode);
+        MarkRowsDirty(y, y + font[1]);
+        return;
+    }
+    if(x % 8 == 0)
+    {
+        DrawLineOfText(x / 8, y, new_string, font, mode);
+        return;
+    }
+
+    switch(FontWidthInBytes(font))
+    {
+    case 1:
+        DrawLineOfTextShifted<1>(x, y, new_string, font, mode);
+        break;
+    case 2:
+        DrawLineOfTextShifted<2>(x, y, new_string, font, mode);
+        break;
+    case 3:
+        DrawLineOfTextShifted<3>(x, y, new_string, font, mode);
+        break;
+    case 4:
+        DrawLineOfTextShifted<4>(x, y, new_string, font, mode);
+        break;
+    default:
+        // Wider fonts are not shipped, draw them at the nearest byte
+        DrawLineOfText(x / 8, y, new_string, font, mode);
+        return;
+    }
+    MarkRowsDirty(y, y + font[1]);
+}
+
+uint16_t SharpMipDisplay::GetTextWidth(const std::string& text, const uint8_t font[])
+{
+    if(!IsProportionalFont(font))
+    {
+        return text.size() * FontWidthInBytes(font) * 8;
+    }
+    int width{0};
+    for(size_t i = 0; i < text.size(); ++i)
     {
-        DrawLineOfTextAdd(x, y, new_string, font);
+        if(i > 0)
+        {
+            width += KerningAdjustment(font, text[i - 1], text[i]);
+        }
+        width += ProportionalGlyphAdvance(font, text[i]);
     }
+    return std::max(width, 0);
 }
 
 void SharpMipDisplay::DrawHorizontalLine(uint16_t x)
 {
+    if(x >= kScreenHeight_)
+    {
+        return;
+    }
     for(std::size_t i = 0; i < kScreenWidthInWords_; ++i)
     {
-        screen_buffer_[x*kScreenWidthInWords_ + i] = 0b00000000;
+        RowPointer(x)[i] = 0b00000000;
     }
+    MarkRowsDirty(x, x + 1);
 }
 
 void SharpMipDisplay::DrawVerticalLine(uint16_t y)
 {
-    
-    for(std::size_t i = 0; i < kScreenHeight_; ++i)
-    {
-        SetPixel(y, i);
-    }
+    DrawVerticalSegment(y, 0, kScreenHeight_ - 1);
 }
 
 void SharpMipDisplay::SetPixel(uint16_t x, uint16_t y)
 {
+    if(x >= kScreenWidth_ || y >= kScreenHeight_)
+    {
+        return;
+    }
     uint16_t pixel_in_byte = x % 8;
     uint16_t column_in_bytes = (x - pixel_in_byte) / 8;
-    uint8_t mask = 0b000000001 << pixel_in_byte;
-    screen_buffer_[y*kScreenWidthInWords_ + column_in_bytes] &= ~mask;
+    // MSB is the leftmost pixel, the same as in fonts and on the panel
+    uint8_t mask = 0b10000000 >> pixel_in_byte;
+    RowPointer(y)[column_in_bytes] &= ~mask;
+    MarkRowsDirty(y, y + 1);
 }
 
 void SharpMipDisplay::ResetPixel(uint16_t x, uint16_t y)
 {
+    if(x >= kScreenWidth_ || y >= kScreenHeight_)
+    {
+        return;
+    }
     uint16_t pixel_in_byte = x % 8;
     uint16_t column_in_bytes = (x - pixel_in_byte) / 8;
-    uint8_t mask = 0b000000001 << pixel_in_byte;
-    screen_buffer_[y*kScreenWidthInWords_ + column_in_bytes] |= mask;
+    uint8_t mask = 0b10000000 >> pixel_in_byte;
+    RowPointer(y)[column_in_bytes] |= mask;
+    MarkRowsDirty(y, y + 1);
 }
 
-void SharpMipDisplay::RefreshScreen(uint8_t line_start, uint8_t line_end)
+SharpMipDisplay::LineRange SharpMipDisplay::FillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
 {
-    // printf("-- SharpMipDisplay::RefreshScreen \n");
-    
-    gpio_put(kDisplaySpiCsPin_, 1);
+    return ApplyRect(x, y, width, height, PixelOp::kSet);
+}
 
-    int length_of_buffer = 1 + (line_end - line_start) * (1 + kScreenWidthInWords_ + 1) + 1;
-    uint8_t buf[length_of_buffer];
-    int buf_iterator{0};
-    // buf[buf_iterator] = 0b10000000;    // command
-    if(vcom_bool_)
-    {
-        buf[0] = 0b11000000;
-        vcom_bool_ = false;
-    }
-    else
+SharpMipDisplay::LineRange SharpMipDisplay::ClearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    return ApplyRect(x, y, width, height, PixelOp::kClear);
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::InvertRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height)
+{
+    return ApplyRect(x, y, width, height, PixelOp::kInvert);
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::BlitBitmap(int16_t x, int16_t y, const uint8_t bitmap[], uint16_t width, uint16_t height,
+                                                       uint16_t stride, RasterOp op)
+{
+    const int32_t x_start = std::max<int32_t>(x, 0);
+    const int32_t x_end = std::min<int32_t>(x + width, kScreenWidth_);
+    const int32_t y_start = std::max<int32_t>(y, 0);
+    const int32_t y_end = std::min<int32_t>(y + height, kScreenHeight_);
+    if(x_start >= x_end || y_start >= y_end)
     {
-        buf[0] = 0b10000000;
-        vcom_bool_ = true;
+        return LineRange{0, 0};
     }
-    buf_iterator++;
-
-    for (size_t i = line_start; i < line_end; i++)
+    switch(op)
     {
-        uint8_t little_endian_line_address = SwapBigToLittleEndian(i);
-        buf[buf_iterator] = little_endian_line_address;    //line address
-        buf_iterator++;
-        for (size_t j = 0; j < kScreenWidthInWords_; ++j)
-        {
-            buf[buf_iterator] = screen_buffer_[i * kScreenWidthInWords_ + j];
-            buf_iterator++;
-        }
-        buf[buf_iterator] = 0b00000000;     //end line trailer
-        buf_iterator++;
+    case RasterOp::kCopy:
+        BlitBitmapRows<RasterOp::kCopy>(x, y, bitmap, nullptr, width, stride, x_start, x_end, y_start, y_end);
+        break;
+    case RasterOp::kAnd:
+        BlitBitmapRows<RasterOp::kAnd>(x, y, bitmap, nullptr, width, stride, x_start, x_end, y_start, y_end);
+        break;
+    case RasterOp::kOr:
+        BlitBitmapRows<RasterOp::kOr>(x, y, bitmap, nullptr, width, stride, x_start, x_end, y_start, y_end);
+        break;
+    case RasterOp::kXor:
+        BlitBitmapRows<RasterOp::kXor>(x, y, bitmap, nullptr, width, stride, x_start, x_end, y_start, y_end);
+        break;
+    case RasterOp::kAndNot:
+        BlitBitmapRows<RasterOp::kAndNot>(x, y, bitmap, nullptr, width, stride, x_start, x_end, y_start, y_end);
+        break;
     }
-
-    buf[buf_iterator] = 0b00000000;     //end transmission trailer
-    spi_write_blocking(kSPI_, buf, length_of_buffer);
-    gpio_put(kDisplaySpiCsPin_, 0);
-    sleep_ms(10);
+    MarkRowsDirty(y_start, y_end);
+    return LineRange{static_cast<uint8_t>(y_start), static_cast<uint8_t>(y_end)};
 }
 
-void SharpMipDisplay::ClearScreen()
+SharpMipDisplay::LineRange SharpMipDisplay::DrawSprite(Sprite& sprite, int16_t x, int16_t y)
 {
-    // printf("-- ClearScreen \n");
+    const LineRange old_rows = HideSprite(sprite);
+    sprite.visible_ = true;
+    sprite.x_ = x;
+    sprite.y_ = y;
+    sprite.saved_rows_ = 0;
 
-    for(int i = 0; i < (kScreenWidthInWords_ * kScreenHeight_); ++i) 
+    const int32_t x_start = std::max<int32_t>(x, 0);
+    const int32_t x_end = std::min<int32_t>(x + sprite.kWidth_, kScreenWidth_);
+    const int32_t y_start = std::max<int32_t>(y, 0);
+    const int32_t y_end = std::min<int32_t>(y + sprite.kHeight_, kScreenHeight_);
+    if(x_start >= x_end || y_start >= y_end)
     {
-        screen_buffer_[i] = 0b11111111;
+        return old_rows;
     }
 
-    gpio_put(kDisplaySpiCsPin_, 1);
-    uint8_t buf[2];
-    // buf[0] = 0b01100000;    // command
-    if(vcom_bool_)
+    // Whole bytes below the sprite are saved, the first and last of them only partly covered
+    sprite.saved_first_byte_ = x_start / 8;
+    sprite.saved_bytes_per_row_ = (x_end - 1) / 8 - x_start / 8 + 1;
+    sprite.saved_first_row_ = y_start;
+    sprite.saved_rows_ = y_end - y_start;
+    uint8_t* background = sprite.background_;
+    for(int32_t row = y_start; row < y_end; ++row)
     {
-        buf[0] = 0b01100000;
-        vcom_bool_ = false;
+        const uint8_t* pixels = RowPointer(row) + sprite.saved_first_byte_;
+        std::copy(pixels, pixels + sprite.saved_bytes_per_row_, background);
+        background += sprite.saved_bytes_per_row_;
     }
-    else
+
+    BlitBitmapRows<RasterOp::kCopy>(x, y, sprite.kImage_, sprite.kMask_, sprite.kWidth_, sprite.kStride_, x_start, x_end, y_start, y_end);
+    MarkRowsDirty(y_start, y_end);
+    if(old_rows.start == old_rows.end)
     {
-        buf[0] = 0b00100000;
-        vcom_bool_ = true;
+        return LineRange{static_cast<uint8_t>(y_start), static_cast<uint8_t>(y_end)};
     }
-    buf[1] = 0b00000000;
-    spi_write_blocking(kSPI_, buf, 2);
-    gpio_put(kDisplaySpiCsPin_, 0);
+    return LineRange{std::min<uint8_t>(old_rows.start, y_start), std::max<uint8_t>(old_rows.end, y_end)};
 }
 
-void SharpMipDisplay::ToggleVCOM()
+SharpMipDisplay::LineRange SharpMipDisplay::HideSprite(Sprite& sprite)
 {
-    // printf("-- SharpMipDisplay::ToggleVCOM \n");
-    gpio_put(kDisplaySpiCsPin_, 1);
-    uint8_t buf[22];
-    if(vcom_bool_)
+    if(!sprite.visible_)
     {
-        buf[0] = 0b01000000;
-        vcom_bool_ = false;
+        return LineRange{0, 0};
     }
-    else
+    sprite.visible_ = false;
+    if(sprite.saved_rows_ == 0)
     {
-        buf[0] = 0b00000000;
-        vcom_bool_ = true;
+        return LineRange{0, 0};
     }
-    buf[1] = 0b00000000;
-    spi_write_blocking(kSPI_, buf, 2);
-    gpio_put(kDisplaySpiCsPin_, 0);
-    sleep_ms(10);
+    const uint8_t* background = sprite.background_;
+    const uint16_t row_end = sprite.saved_first_row_ + sprite.saved_rows_;
+    for(uint16_t row = sprite.saved_first_row_; row < row_end; ++row)
+    {
+        std::copy(background, background + sprite.saved_bytes_per_row_, RowPointer(row) + sprite.saved_first_byte_);
+        background += sprite.saved_bytes_per_row_;
+    }
+    MarkRowsDirty(sprite.saved_first_row_, row_end);
+    return LineRange{static_cast<uint8_t>(sprite.saved_first_row_), static_cast<uint8_t>(row_end)};
 }
 
-
-
-/********** PRIVATE **********/
-
-uint8_t SharpMipDisplay::SwapBigToLittleEndian(uint8_t big_endian)
+SharpMipDisplay::LineRange SharpMipDisplay::DrawHorizontalSegment(uint16_t x0, uint16_t x1, uint16_t y, PixelOp op)
 {
-    std::string string_be = std::bitset<8>(big_endian).to_string();
-    std::reverse(string_be.begin(), string_be.end());
-    std::bitset<8> bitset_le(string_be);
-    uint8_t little_e = static_cast<uint8_t>(bitset_le.to_ulong());
-    
-    return little_e;
+    LineRange dirty{0, 0};
+    ApplyClippedSpan(x0, x1, y, op, dirty);
+    MarkRowsDirty(dirty.start, dirty.end);
+    return dirty;
 }
 
-void SharpMipDisplay::DrawLineOfTextReplace(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[])
+SharpMipDisplay::LineRange SharpMipDisplay::DrawHorizontalSegments(const HorizontalSegment segments[], size_t amount_of_segments, PixelOp op)
 {
-    uint8_t char_width_in_bytes = font[0];
-    uint8_t char_height_in_pixels = font[1];
-    uint8_t first_char_in_fonts = font[2];
-    uint16_t char_size_in_bytes = char_width_in_bytes * char_height_in_pixels;
-    
-    // Draw given text
-    uint16_t char_counter{0};
-    for(const auto& character : new_string)     // iterate through every char in string
+    LineRange dirty{0, 0};
+    for(size_t i = 0; i < amount_of_segments; ++i)
     {
-        int char_position{(character - first_char_in_fonts)*char_size_in_bytes + 3};
-
-        for(std::size_t i = 0; i < char_width_in_bytes; ++i)
+        if(ApplyClippedSpan(segments[i].x0, segments[i].x1, segments[i].y, op, dirty))
         {
-            for(std::size_t j = 0; j < char_height_in_pixels; ++j)  //iterate vertically through every line in a char
-            {
-                uint16_t row = (y + j)*kScreenWidthInWords_;
-                uint16_t col = x + char_counter*char_width_in_bytes + i;
-                screen_buffer_[row + col] = font[char_position + i + j*char_width_in_bytes];
-            }
+            MarkRowsDirty(segments[i].y, segments[i].y + 1);
         }
-
-        ++char_counter;
     }
+    return dirty;
+}
 
-    // Erase ramaining cols, which are not filled with new text
-    uint16_t remaining_cols{kScreenWidthInWords_ - char_counter*char_width_in_bytes};
-    uint8_t blank_pixel{0b11111111};
-    for(std::size_t i = 0; i < remaining_cols; ++i)
+SharpMipDisplay::LineRange SharpMipDisplay::DrawVerticalSegment(uint16_t x, uint16_t y0, uint16_t y1, PixelOp op)
+{
+    if(y0 > y1)
     {
-        for(std::size_t j = 0; j < char_height_in_pixels; ++j)  //iterate vertically through every line in a char
-        {
-            uint16_t row = (y + j)*kScreenWidthInWords_;
-            uint16_t col = x + (char_counter*char_width_in_bytes) + i;
-            screen_buffer_[row + col] = blank_pixel;
-        }
+        std::swap(y0, y1);
     }
+    if(x >= kScreenWidth_ || y0 >= kScreenHeight_)
+    {
+        return LineRange{0, 0};
+    }
+    y1 = std::min<uint16_t>(y1, kScreenHeight_ - 1);
+    const uint8_t byte_index = x / 8;
+    const uint8_t mask = 0b10000000 >> (x % 8);
+    ApplyColumnMasks(&byte_index, &mask, 1, y0, y1, op);
+    return LineRange{static_cast<uint8_t>(y0), static_cast<uint8_t>(y1 + 1)};
 }
 
-void SharpMipDisplay::DrawLineOfTextMix(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[])
+SharpMipDisplay::LineRange SharpMipDisplay::DrawVerticalSegments(const uint16_t columns[], size_t amount_of_columns, uint16_t y0, uint16_t y1,
+                                                                 PixelOp op)
 {
-    uint8_t char_width_in_bytes = font[0];
-    uint8_t char_height_in_pixels = font[1];
-    uint8_t first_char_in_fonts = font[2];
-    uint16_t char_size_in_bytes = char_width_in_bytes * char_height_in_pixels;
-    
-    uint16_t char_counter{0};
-
-    for(const auto& character : new_string)     // iterate through every char in string
+    if(y0 > y1)
     {
-        int char_position{(character - first_char_in_fonts)*char_size_in_bytes + 3};
-
-        for(std::size_t i = 0; i < char_width_in_bytes; ++i)
+        std::swap(y0, y1);
+    }
+    if(y0 >= kScreenHeight_)
+    {
+        return LineRange{0, 0};
+    }
+    y1 = std::min<uint16_t>(y1, kScreenHeight_ - 1);
+    uint8_t byte_indexes[kMaxSegmentBytes_];
+    uint8_t masks[kMaxSegmentBytes_];
+    size_t amount_of_bytes = 0;
+    bool changed = false;
+    for(size_t i = 0; i < amount_of_columns; ++i)
+    {
+        if(columns[i] >= kScreenWidth_)
         {
-            for(std::size_t j = 0; j < char_height_in_pixels; ++j)  //iterate vertically through every line in a char
+            continue;
+        }
+        const uint8_t byte_index = columns[i] / 8;
+        const uint8_t mask = 0b10000000 >> (columns[i] % 8);
+        size_t j = 0;
+        while(j < amount_of_bytes && byte_indexes[j] != byte_index)
+        {
+            ++j;
+        }
+        if(j == amount_of_bytes)
+        {
+            if(amount_of_bytes == kMaxSegmentBytes_)
             {
-                uint16_t row = (y + j)*kScreenWidthInWords_;
-                uint16_t col = x + char_counter*char_width_in_bytes + i;
-                screen_buffer_[row + col] = font[char_position + i + j*char_width_in_bytes];
+                ApplyColumnMasks(byte_indexes, masks, amount_of_bytes, y0, y1, op);
+                amount_of_bytes = 0;
+                j = 0;
             }
+            byte_indexes[j] = byte_index;
+            masks[j] = 0;
+            ++amount_of_bytes;
         }
-
-        ++char_counter;
+        // A column given twice is inverted twice, the same as if the bytes were not merged
+        masks[j] = (op == PixelOp::kInvert) ? (masks[j] ^ mask) : (masks[j] | mask);
+        changed = true;
+    }
+    if(!changed)
+    {
+        return LineRange{0, 0};
     }
+    ApplyColumnMasks(byte_indexes, masks, amount_of_bytes, y0, y1, op);
+    return LineRange{static_cast<uint8_t>(y0), static_cast<uint8_t>(y1 + 1)};
 }
 
-void SharpMipDisplay::DrawLineOfTextAdd(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[])
+SharpMipDisplay::LineRange SharpMipDisplay::DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, PixelOp op)
 {
-    uint8_t char_width_in_bytes = font[0];
-    uint8_t char_height_in_pixels = font[1];
-    uint8_t first_char_in_fonts = font[2];
-    uint16_t char_size_in_bytes = char_width_in_bytes * char_height_in_pixels;
-    
-    uint16_t char_counter{0};
-
-    for(const auto& character : new_string)     // iterate through every char in string
+    if(thickness > 1)
     {
-        int char_position{(character - first_char_in_fonts)*char_size_in_bytes + 3};
-
-        for(std::size_t i = 0; i < char_width_in_bytes; ++i)
+        return DrawThickLine(x0, y0, x1, y1, thickness, op);
+    }
+    // Walk downwards, so pixels of every row are next to each other and are drawn as one span
+    if(y0 > y1)
+    {
+        std::swap(x0, x1);
+        std::swap(y0, y1);
+    }
+    const int32_t dx = std::abs(x1 - x0);
+    const int32_t dy = -(y1 - y0);
+    const int32_t step_x = (x0 < x1) ? 1 : -1;
+    int32_t error = dx + dy;
+    int32_t x = x0;
+    int32_t y = y0;
+    int32_t span_start = x0;
+    LineRange dirty{0, 0};
+    while(x != x1 || y != y1)
+    {
+        const int32_t doubled_error = 2 * error;
+        int32_t next_x = x;
+        if(doubled_error >= dy)
         {
-            for(std::size_t j = 0; j < char_height_in_pixels; ++j)  //iterate vertically through every line in a char
-            {
-                uint16_t row = y + j*kScreenWidthInWords_;
-                uint16_t col = x + char_counter*char_width_in_bytes + i;
-                screen_buffer_[row + col] &= font[char_position + i + j*char_width_in_bytes];
-            }
+            error += dy;
+            next_x += step_x;
+        }
+        if(doubled_error <= dx)
+        {
+            error += dx;
+            ApplyClippedSpan(span_start, x, y, op, dirty);
+            ++y;
+            span_start = next_x;
         }
+        x = next_x;
+    }
+    ApplyClippedSpan(span_start, x, y, op, dirty);
+    MarkRowsDirty(dirty.start, dirty.end);
+    return dirty;
+}
 
-        ++char_counter;
+SharpMipDisplay::LineRange SharpMipDisplay::DrawCircle(int16_t x, int16_t y, uint16_t radius, PixelOp op)
+{
+    return DrawEllipse(x, y, radius, radius, op);
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::FillCircle(int16_t x, int16_t y, uint16_t radius, PixelOp op)
+{
+    return FillEllipse(x, y, radius, radius, op);
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::DrawEllipse(int16_t x, int16_t y, uint16_t radius_x, uint16_t radius_y, PixelOp op)
+{
+    return DrawRowSpans(y - radius_y, y + radius_y, false, op, [=](int32_t row, int32_t& left, int32_t& right)
+    {
+        const int32_t half_width = EllipseHalfWidth(radius_x, radius_y, row - y);
+        left = x - half_width;
+        right = x + half_width;
+        return half_width >= 0;
+    });
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::FillEllipse(int16_t x, int16_t y, uint16_t radius_x, uint16_t radius_y, PixelOp op)
+{
+    return DrawRowSpans(y - radius_y, y + radius_y, true, op, [=](int32_t row, int32_t& left, int32_t& right)
+    {
+        const int32_t half_width = EllipseHalfWidth(radius_x, radius_y, row - y);
+        left = x - half_width;
+        right = x + half_width;
+        return half_width >= 0;
+    });
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::DrawArc(int16_t x, int16_t y, uint16_t radius, uint16_t start_angle, uint16_t end_angle,
+                                                    uint8_t thickness, PixelOp op)
+{
+    return DrawRing(x, y, radius, static_cast<int32_t>(radius) - thickness, start_angle, end_angle, op);
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::FillArc(int16_t x, int16_t y, uint16_t radius, uint16_t start_angle, uint16_t end_angle,
+                                                    PixelOp op)
+{
+    return DrawRing(x, y, radius, -1, start_angle, end_angle, op);
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::DrawRoundRect(int16_t x, int16_t y, uint16_t width, uint16_t height, uint16_t radius,
+                                                          PixelOp op)
+{
+    if(width == 0 || height == 0)
+    {
+        return LineRange{0, 0};
+    }
+    radius = std::min<uint16_t>(radius, (std::min(width, height) - 1) / 2);
+    const int32_t top = y + radius;
+    const int32_t bottom = y + height - 1 - radius;
+    return DrawRowSpans(y, y + height - 1, false, op, [=](int32_t row, int32_t& left, int32_t& right)
+    {
+        const int32_t dy = (row < top) ? top - row : ((row > bottom) ? row - bottom : 0);
+        const int32_t indent = radius - EllipseHalfWidth(radius, radius, dy);
+        left = x + indent;
+        right = x + width - 1 - indent;
+        return true;
+    });
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::FillRoundRect(int16_t x, int16_t y, uint16_t width, uint16_t height, uint16_t radius,
+                                                          PixelOp op)
+{
+    if(width == 0 || height == 0)
+    {
+        return LineRange{0, 0};
+    }
+    radius = std::min<uint16_t>(radius, (std::min(width, height) - 1) / 2);
+    const int32_t top = y + radius;
+    const int32_t bottom = y + height - 1 - radius;
+    return DrawRowSpans(y, y + height - 1, true, op, [=](int32_t row, int32_t& left, int32_t& right)
+    {
+        const int32_t dy = (row < top) ? top - row : ((row > bottom) ? row - bottom : 0);
+        const int32_t indent = radius - EllipseHalfWidth(radius, radius, dy);
+        left = x + indent;
+        right = x + width - 1 - indent;
+        return true;
+    });
+}
+
+void SharpMipDisplay::RefreshScreen(uint8_t line_start, uint8_t line_end)
+{
+    // printf("-- SharpMipDisplay::RefreshScreen \n");
+
+    uint32_t rows[kRowBitmapWords_]{};
+    for (size_t i = line_start; i < line_end; i++)
+    {
+        rows[i / 32] |= 1UL << (i % 32);
+    }
+    SendLines(rows);
+}
+
+void SharpMipDisplay::Flush()
+{
+    Present();
+}
+
+void SharpMipDisplay::EnableDoubleBuffering(bool enable)
+{
+    // The front buffer may be read by the transfer in progress
+    WaitIdle();
+    if(enable && front_buffer_ == screen_buffer_)
+    {
+        front_buffer_ = new uint8_t[kRowStride_ * kScreenHeight_];
+        std::memcpy(front_buffer_, screen_buffer_, kRowStride_ * kScreenHeight_);
+        std::fill(changed_rows_, changed_rows_ + kRowBitmapWords_, 0);
+    }
+    else if(!enable && front_buffer_ != screen_buffer_)
+    {
+        if(front_buffer_ == kPrimaryBuffer_)
+        {
+            // Keep the primary buffer, it may not be allocated by the display
+            std::memcpy(kPrimaryBuffer_, screen_buffer_, kRowStride_ * kScreenHeight_);
+            delete[] screen_buffer_;
+            screen_buffer_ = kPrimaryBuffer_;
+        }
+        else
+        {
+            delete[] front_buffer_;
+        }
+        front_buffer_ = screen_buffer_;
+    }
+}
+
+void SharpMipDisplay::Present()
+{
+    if(frame_depth_ > 0)
+    {
+        frame_present_ = true;
+        return;
+    }
+    if(front_buffer_ != screen_buffer_)
+    {
+        // The old front buffer becomes the back buffer, so the transfer reading it has to be completed
+        WaitIdle();
+        std::swap(screen_buffer_, front_buffer_);
+
+        // Carry forward rows changed in the new front buffer, so the new back buffer is the same as the new front buffer
+        for (size_t i = 0; i < kScreenHeight_; i++)
+        {
+            if(changed_rows_[i / 32] & (1UL << (i % 32)))
+            {
+                std::memcpy(RowPointer(i), FrontRowPointer(i), kScreenWidthInWords_);
+            }
+        }
+        std::fill(changed_rows_, changed_rows_ + kRowBitmapWords_, 0);
+
+        // Refreshes do not clear dirty rows of the back buffer, all of them are in the front buffer now
+        uint32_t rows[kRowBitmapWords_];
+        std::copy(dirty_rows_, dirty_rows_ + kRowBitmapWords_, rows);
+        std::fill(dirty_rows_, dirty_rows_ + kRowBitmapWords_, 0);
+        SendLines(rows);
+        return;
+    }
+    SendLines(dirty_rows_);
+}
+
+void SharpMipDisplay::RefreshLines(const LineRange ranges[], size_t amount_of_ranges)
+{
+    // Merging in a bitmap sorts the rows and removes overlaps
+    uint32_t rows[kRowBitmapWords_]{};
+    for (size_t i = 0; i < amount_of_ranges; ++i)
+    {
+        for (size_t j = ranges[i].start; j < ranges[i].end; j++)
+        {
+            rows[j / 32] |= 1UL << (j % 32);
+        }
+    }
+    SendLines(rows);
+}
+
+void SharpMipDisplay::RefreshLines(const uint32_t rows[])
+{
+    SendLines(rows);
+}
+
+void SharpMipDisplay::SetTiming(const SharpMipTiming& timing)
+{
+    WaitIdle();
+    timing_ = timing;
+}
+
+void SharpMipDisplay::EnableShadowBuffer(bool enable)
+{
+    // The shadow buffer may be used by the transfer in progress
+    WaitIdle();
+    if(enable && shadow_buffer_ == nullptr)
+    {
+        // The same layout as screen buffer, so rows of both buffers have the same alignment
+        shadow_buffer_ = new uint8_t[kRowStride_ * kScreenHeight_];
+        shadow_valid_ = false;
+    }
+    else if(!enable)
+    {
+        delete[] shadow_buffer_;
+        shadow_buffer_ = nullptr;
+    }
+}
+
+void SharpMipDisplay::EnableGlyphCache(GlyphCache* cache)
+{
+    glyph_cache_ = cache;
+}
+
+void SharpMipDisplay::EnableAsyncRefresh(SpiDma* dma)
+{
+    WaitIdle();
+    if(dma_ != nullptr)
+    {
+        dma_->SetCompletionHandler(nullptr, nullptr);
+    }
+    dma_ = dma;
+    if(dma_ != nullptr)
+    {
+        dma_->SetCompletionHandler(&SharpMipDisplay::OnTransferComplete, this);
+        // DMA needs the whole packet in memory
+        if(kLayout_ == BufferLayout::kPacked && transfer_buffer_ == nullptr)
+        {
+            transfer_buffer_ = (kPacketStorage_ != nullptr) ? kPacketStorage_ : new uint8_t[1 + kScreenHeight_ * (1 + kScreenWidthInWords_ + 1) + 1];
+        }
+    }
+    else
+    {
+        if(transfer_buffer_ != kPacketStorage_)
+        {
+            delete[] transfer_buffer_;
+        }
+        transfer_buffer_ = nullptr;
+    }
+}
+
+void SharpMipDisplay::SetRefreshCallback(void (*callback)(void* context), void* context)
+{
+    WaitIdle();
+    refresh_callback_ = callback;
+    refresh_callback_context_ = context;
+}
+
+bool SharpMipDisplay::IsBusy() const
+{
+    return (pipeline_queue_ != nullptr && (!pipeline_queue_->IsEmpty() || pipeline_active_ || vcom_requested_)) || transfer_in_progress_;
+}
+
+void SharpMipDisplay::WaitIdle() const
+{
+    // Core 1 marks itself active before it takes a job or a VCOM request, so an empty queue, no request and inactive core 1
+    // mean all jobs are done
+    while((pipeline_queue_ != nullptr && (!pipeline_queue_->IsEmpty() || pipeline_active_ || vcom_requested_)) || transfer_in_progress_)
+    {
+        tight_loop_contents();
+    }
+}
+
+void SharpMipDisplay::EnableExtcominPwm(uint extcomin_pin, float frequency_hz)
+{
+    DisableHardwareVcom();
+
+    // Phase-correct PWM counts up and down, so one period is 2 * (wrap + 1) * divider cycles
+    const float cycles_per_period{clock_get_hz(clk_sys) / (2.0f * frequency_hz)};
+    float divider{cycles_per_period / 65536.0f};
+    divider = std::min(std::max(divider, 1.0f), 255.9375f);
+    uint32_t wrap = static_cast<uint32_t>(cycles_per_period / divider);
+    wrap = std::min(std::max(wrap, uint32_t{2}), uint32_t{65536}) - 1;
+
+    extcomin_pin_ = extcomin_pin;
+    gpio_set_function(extcomin_pin_, GPIO_FUNC_PWM);
+    uint slice = pwm_gpio_to_slice_num(extcomin_pin_);
+    pwm_config config = pwm_get_default_config();
+    pwm_config_set_phase_correct(&config, true);
+    pwm_config_set_clkdiv(&config, divider);
+    pwm_config_set_wrap(&config, wrap);
+    pwm_init(slice, &config, false);
+    pwm_set_gpio_level(extcomin_pin_, (wrap + 1) / 2);
+    pwm_set_enabled(slice, true);
+    vcom_mode_ = VcomMode::kExtcominPwm;
+}
+
+void SharpMipDisplay::EnableVcomTimer(uint32_t period_ms)
+{
+    DisableHardwareVcom();
+    vcom_toggled_ = false;
+    vcom_requested_ = false;
+    // Negative delay keeps the period independent of callback duration
+    add_repeating_timer_ms(-static_cast<int32_t>(period_ms), &SharpMipDisplay::OnVcomTimer, this, &vcom_timer_);
+    vcom_mode_ = VcomMode::kTimer;
+}
+
+void SharpMipDisplay::DisableHardwareVcom()
+{
+    if(vcom_mode_ == VcomMode::kExtcominPwm)
+    {
+        pwm_set_enabled(pwm_gpio_to_slice_num(extcomin_pin_), false);
+        gpio_set_function(extcomin_pin_, GPIO_FUNC_SIO);
+        gpio_set_dir(extcomin_pin_, GPIO_OUT);
+        gpio_put(extcomin_pin_, 0);
+    }
+    else if(vcom_mode_ == VcomMode::kTimer)
+    {
+        cancel_repeating_timer(&vcom_timer_);
+    }
+    vcom_mode_ = VcomMode::kSoftware;
+}
+
+void SharpMipDisplay::ClearScreen()
+{
+    // printf("-- ClearScreen \n");
+
+    for(int i = 0; i < kScreenHeight_; ++i) 
+    {
+        std::fill(RowPointer(i), RowPointer(i) + kScreenWidthInWords_, 0b11111111);
+    }
+    std::fill(dirty_rows_, dirty_rows_ + kRowBitmapWords_, 0);
+    std::fill(changed_rows_, changed_rows_ + kRowBitmapWords_, 0xFFFFFFFF);
+
+    if(front_buffer_ != screen_buffer_)
+    {
+        // With double buffering only the back buffer is cleared, the panel keeps showing the front buffer until Present() sends the cleared rows
+        MarkRowsDirty(0, kScreenHeight_);
+        return;
+    }
+    if(frame_depth_ > 0 || (shadow_buffer_ != nullptr && shadow_valid_))
+    {
+        // The clear is sent together with the next refresh, as rows or as the clear command, only if it is still needed then
+        MarkRowsDirty(0, kScreenHeight_);
+        std::copy(dirty_rows_, dirty_rows_ + kRowBitmapWords_, pending_rows_);
+        return;
+    }
+    SendClearCommand();
+}
+
+void SharpMipDisplay::BeginFrame()
+{
+    ++frame_depth_;
+}
+
+void SharpMipDisplay::EndFrame()
+{
+    if(frame_depth_ == 0 || --frame_depth_ > 0)
+    {
+        return;
+    }
+
+    if(frame_present_)
+    {
+        frame_present_ = false;
+        Present();
+        return;
+    }
+    // Sends rows of all refreshes deferred during the frame
+    uint32_t rows[kRowBitmapWords_]{};
+    SendLines(rows);
+}
+
+void SharpMipDisplay::ToggleVCOM()
+{
+    // printf("-- SharpMipDisplay::ToggleVCOM \n");
+    if(vcom_mode_ == VcomMode::kTimer && pipeline_queue_ == nullptr)
+    {
+        if(vcom_requested_.exchange(false))
+        {
+            TransmitVcom();
+            // Sent for the timer, so the next tick is not skipped like after a refresh
+            vcom_toggled_ = false;
+        }
+        return;
+    }
+    if(vcom_mode_ != VcomMode::kSoftware)
+    {
+        return;
+    }
+    if(pipeline_queue_ != nullptr)
+    {
+        PostTransferJob(TransferJob::Type::kToggleVcom, nullptr);
+        return;
+    }
+    TransmitVcom();
+}
+
+void SharpMipDisplay::EnablePipeline()
+{
+    if(pipeline_queue_ != nullptr)
+    {
+        return;
+    }
+    pipeline_queue_ = new SpscQueue<TransferJob, kPipelineDepth_>();
+    multicore_launch_core1(&SharpMipDisplay::Core1Entry);
+    multicore_fifo_push_blocking(reinterpret_cast<uintptr_t>(this));
+}
+
+
+
+/********** PRIVATE **********/
+
+void SharpMipDisplay::TransmitVcom()
+{
+    ClaimBus();
+    BeginTransaction();
+    uint8_t buf[2];
+    if(vcom_bool_)
+    {
+        buf[0] = 0b01000000;
+        vcom_bool_ = false;
+    }
+    else
+    {
+        buf[0] = 0b00000000;
+        vcom_bool_ = true;
+    }
+    buf[1] = 0b00000000;
+    spi_write_blocking(kSPI_, buf, 2);
+    EndTransaction();
+}
+
+uint8_t SharpMipDisplay::SwapBigToLittleEndian(uint8_t big_endian)
+{
+    return kBitReversalTable[big_endian];
+}
+
+void SharpMipDisplay::SendLines(const uint32_t rows[])
+{
+    if(frame_depth_ > 0)
+    {
+        // Merged with all other refreshes of the frame and sent by EndFrame()
+        for (size_t i = 0; i < kRowBitmapWords_; ++i)
+        {
+            pending_rows_[i] |= rows[i];
+        }
+        return;
+    }
+
+    // rows may point to dirty_rows_, so copy it before the dirty rows are cleared
+    uint32_t rows_to_send[kRowBitmapWords_];
+    std::copy(rows, rows + kRowBitmapWords_, rows_to_send);
+    for (size_t i = 0; i < kRowBitmapWords_; ++i)
+    {
+        rows_to_send[i] |= pending_rows_[i];
+        pending_rows_[i] = 0;
+        if(front_buffer_ == screen_buffer_)
+        {
+            dirty_rows_[i] &= ~rows_to_send[i];
+        }
+    }
+
+    if(pipeline_queue_ != nullptr)
+    {
+        PostTransferJob(TransferJob::Type::kLines, rows_to_send);
+        return;
+    }
+    TransmitLines(rows_to_send);
+}
+
+void SharpMipDisplay::TransmitLines(uint32_t rows_to_send[])
+{
+    if(shadow_buffer_ != nullptr && shadow_valid_)
+    {
+        if(DropUnchangedLines(rows_to_send))
+        {
+            // The new frame is fully white, the 2 bytes long clear command is enough
+            TransmitClear();
+            return;
+        }
+    }
+
+    int amount_of_lines{0};
+    for (size_t i = 0; i < kScreenHeight_; i++)
+    {
+        if(rows_to_send[i / 32] & (1UL << (i % 32)))
+        {
+            ++amount_of_lines;
+        }
+    }
+    if(amount_of_lines == 0)
+    {
+        return;
+    }
+
+    // transfer_buffer_ and transfer_segments_ are used by the transfer in progress
+    ClaimBus();
+    UpdateShadow(rows_to_send);
+    if(kLayout_ == BufferLayout::kWire)
+    {
+        SendSegments(BuildWireSegments(rows_to_send));
+        return;
+    }
+
+    if(dma_ == nullptr)
+    {
+        StreamLines(rows_to_send);
+        return;
+    }
+    int length_of_buffer = 1 + amount_of_lines * (1 + kScreenWidthInWords_ + 1) + 1;
+    BuildLinesPacket(rows_to_send, transfer_buffer_);
+    transfer_segments_[0] = {transfer_buffer_, static_cast<size_t>(length_of_buffer)};
+    SendSegments(1);
+}
+
+uint8_t SharpMipDisplay::LineWriteCommand()
+{
+    uint8_t command;
+    if(vcom_bool_)
+    {
+        command = 0b11000000;
+        vcom_bool_ = false;
+    }
+    else
+    {
+        command = 0b10000000;
+        vcom_bool_ = true;
+    }
+    return command;
+}
+
+void SharpMipDisplay::UpdateShadow(const uint32_t rows[])
+{
+    if(shadow_buffer_ == nullptr)
+    {
+        return;
+    }
+    for (size_t i = 0; i < kScreenHeight_; i++)
+    {
+        if(rows[i / 32] & (1UL << (i % 32)))
+        {
+            std::memcpy(&shadow_buffer_[i * kRowStride_ + kRowOffset_], FrontRowPointer(i), kScreenWidthInWords_);
+        }
+    }
+}
+
+int SharpMipDisplay::BuildLinesPacket(const uint32_t rows[], uint8_t* buf)
+{
+    int buf_iterator{0};
+    buf[buf_iterator] = LineWriteCommand();
+    buf_iterator++;
+
+    for (size_t i = 0; i < kScreenHeight_; i++)
+    {
+        if(!(rows[i / 32] & (1UL << (i % 32))))
+        {
+            continue;
+        }
+
+        uint8_t little_endian_line_address = SwapBigToLittleEndian(i);
+        buf[buf_iterator] = little_endian_line_address;    //line address
+        buf_iterator++;
+        std::memcpy(&buf[buf_iterator], FrontRowPointer(i), kScreenWidthInWords_);
+        buf_iterator += kScreenWidthInWords_;
+        buf[buf_iterator] = 0b00000000;     //end line trailer
+        buf_iterator++;
+    }
+
+    buf[buf_iterator] = 0b00000000;     //end transmission trailer
+    buf_iterator++;
+    return buf_iterator;
+}
+
+void SharpMipDisplay::StreamLines(const uint32_t rows[])
+{
+    const uint8_t command = LineWriteCommand();
+    BeginTransaction();
+    spi_write_blocking(kSPI_, &command, 1);
+    for (size_t i = 0; i < kScreenHeight_; i++)
+    {
+        if(!(rows[i / 32] & (1UL << (i % 32))))
+        {
+            continue;
+        }
+
+        const uint8_t little_endian_line_address = SwapBigToLittleEndian(i);
+        spi_write_blocking(kSPI_, &little_endian_line_address, 1);       //line address
+        spi_write_blocking(kSPI_, FrontRowPointer(i), kScreenWidthInWords_);
+        spi_write_blocking(kSPI_, &kTransmissionTrailer_, 1);             //end line trailer
+    }
+    spi_write_blocking(kSPI_, &kTransmissionTrailer_, 1);                 //end transmission trailer
+    EndTransaction();
+}
+
+size_t SharpMipDisplay::BuildWireSegments(const uint32_t rows[])
+{
+    size_t amount_of_segments{0};
+    wire_command_ = LineWriteCommand();
+    transfer_segments_[amount_of_segments] = {&wire_command_, 1};
+    amount_of_segments++;
+
+    // Every run of consecutive rows is already a valid part of the packet: address, pixels and trailer of each row
+    size_t i{0};
+    while (i < kScreenHeight_)
+    {
+        if(!(rows[i / 32] & (1UL << (i % 32))))
+        {
+            ++i;
+            continue;
+        }
+        size_t run_start{i};
+        while (i < kScreenHeight_ && (rows[i / 32] & (1UL << (i % 32))))
+        {
+            ++i;
+        }
+        transfer_segments_[amount_of_segments] = {&front_buffer_[run_start * kRowStride_], (i - run_start) * kRowStride_};
+        amount_of_segments++;
+    }
+
+    transfer_segments_[amount_of_segments] = {&kTransmissionTrailer_, 1};
+    amount_of_segments++;
+    return amount_of_segments;
+}
+
+void SharpMipDisplay::SendSegments(size_t amount_of_segments)
+{
+    if(dma_ != nullptr)
+    {
+        BeginTransaction();
+        dma_->StartTransfer(transfer_segments_, amount_of_segments);
+        return;
+    }
+
+    BeginTransaction();
+    for (size_t i = 0; i < amount_of_segments; ++i)
+    {
+        spi_write_blocking(kSPI_, transfer_segments_[i].data, transfer_segments_[i].length);
+    }
+    EndTransaction();
+}
+
+void SharpMipDisplay::OnTransferComplete(void* context)
+{
+    SharpMipDisplay* display = static_cast<SharpMipDisplay*>(context);
+    display->EndTransaction();
+    if(display->refresh_callback_ != nullptr)
+    {
+        display->refresh_callback_(display->refresh_callback_context_);
+    }
+}
+
+bool SharpMipDisplay::DropUnchangedLines(uint32_t rows[])
+{
+    bool any_changed{false};
+    bool all_white{true};
+    for (size_t i = 0; i < kScreenHeight_; i++)
+    {
+        const uint8_t* screen_row = FrontRowPointer(i);
+        const uint8_t* shadow_row = &shadow_buffer_[i * kRowStride_ + kRowOffset_];
+        if(rows[i / 32] & (1UL << (i % 32)))
+        {
+            if(IsRowEqual(screen_row, shadow_row))
+            {
+                rows[i / 32] &= ~(1UL << (i % 32));
+            }
+            else
+            {
+                any_changed = true;
+            }
+            all_white = all_white && IsRowWhite(screen_row);
+        }
+        else
+        {
+            // Row is not refreshed, so after the refresh the screen still shows the shadow
+            all_white = all_white && IsRowWhite(shadow_row);
+        }
+    }
+    
+    if(any_changed && all_white)
+    {
+        return true;
+    }
+    if(!any_changed)
+    {
+        // Nothing to send
+        std::fill(rows, rows + kRowBitmapWords_, 0);
+    }
+    return false;
+}
+
+bool SharpMipDisplay::IsRowEqual(const uint8_t* row_a, const uint8_t* row_b) const
+{
+    // Both rows have the same offset in their buffers, so they reach 4-byte alignment at the same index
+    size_t i{0};
+    for (; i < kScreenWidthInWords_ && (reinterpret_cast<uintptr_t>(row_a + i) % 4) != 0; ++i)
+    {
+        if(row_a[i] != row_b[i])
+        {
+            return false;
+        }
+    }
+    for (; i + 4 <= kScreenWidthInWords_; i += 4)
+    {
+        uint32_t word_a;
+        uint32_t word_b;
+        std::memcpy(&word_a, __builtin_assume_aligned(row_a + i, 4), 4);
+        std::memcpy(&word_b, __builtin_assume_aligned(row_b + i, 4), 4);
+        if(word_a != word_b)
+        {
+            return false;
+        }
+    }
+    for (; i < kScreenWidthInWords_; ++i)
+    {
+        if(row_a[i] != row_b[i])
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool SharpMipDisplay::IsRowWhite(const uint8_t* row) const
+{
+    size_t i{0};
+    for (; i < kScreenWidthInWords_ && (reinterpret_cast<uintptr_t>(row + i) % 4) != 0; ++i)
+    {
+        if(row[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    for (; i + 4 <= kScreenWidthInWords_; i += 4)
+    {
+        uint32_t word;
+        std::memcpy(&word, __builtin_assume_aligned(row + i, 4), 4);
+        if(word != 0xFFFFFFFF)
+        {
+            return false;
+        }
+    }
+    for (; i < kScreenWidthInWords_; ++i)
+    {
+        if(row[i] != 0xFF)
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+void SharpMipDisplay::BeginTransaction()
+{
+    uint32_t cs_low_width_us = time_us_32() - cs_low_time_us_;
+    if(cs_low_width_us < timing_.twSCSL)
+    {
+        busy_wait_us_32(timing_.twSCSL - cs_low_width_us);
+    }
+    gpio_put(kDisplaySpiCsPin_, 1);
+    busy_wait_us_32(timing_.tsSCS);
+}
+
+void SharpMipDisplay::EndTransaction()
+{
+    // spi_write_blocking and DMA completion return after the last bit is shifted out
+    busy_wait_us_32(timing_.thSCS);
+    gpio_put(kDisplaySpiCsPin_, 0);
+    cs_low_time_us_ = time_us_32();
+    transfer_in_progress_ = false;
+}
+
+void SharpMipDisplay::ClaimBus()
+{
+    while(true)
+    {
+        uint32_t saved_irq = spin_lock_blocking(bus_lock_);
+        if(!transfer_in_progress_)
+        {
+            transfer_in_progress_ = true;
+            vcom_toggled_ = true;   // every transaction toggles VCOM
+            vcom_requested_ = false;
+            spin_unlock(bus_lock_, saved_irq);
+            return;
+        }
+        spin_unlock(bus_lock_, saved_irq);
+        tight_loop_contents();
+    }
+}
+
+bool SharpMipDisplay::OnVcomTimer(repeating_timer_t* timer)
+{
+    SharpMipDisplay* display = static_cast<SharpMipDisplay*>(timer->user_data);
+    if(display->vcom_toggled_)
+    {
+        // A transaction since the previous tick already toggled VCOM
+        display->vcom_toggled_ = false;
+        return true;
+    }
+    // No SPI from the interrupt. The queue has a single producer, core 0 outside of interrupts, so the command is requested
+    // with a flag: core 1 sends it, without the pipeline the next transaction or ToggleVCOM() does
+    display->vcom_requested_ = true;
+    if(display->pipeline_queue_ != nullptr)
+    {
+        __sev();
+    }
+    return true;
+}
+
+void SharpMipDisplay::SendClearCommand()
+{
+    if(pipeline_queue_ != nullptr)
+    {
+        PostTransferJob(TransferJob::Type::kClear, nullptr);
+        return;
+    }
+    TransmitClear();
+}
+
+void SharpMipDisplay::TransmitClear()
+{
+    ClaimBus();
+    BeginTransaction();
+    uint8_t buf[2];
+    // buf[0] = 0b01100000;    // command
+    if(vcom_bool_)
+    {
+        buf[0] = 0b01100000;
+        vcom_bool_ = false;
+    }
+    else
+    {
+        buf[0] = 0b00100000;
+        vcom_bool_ = true;
+    }
+    buf[1] = 0b00000000;
+    spi_write_blocking(kSPI_, buf, 2);
+    EndTransaction();
+
+    if(shadow_buffer_ != nullptr)
+    {
+        std::fill(shadow_buffer_, shadow_buffer_ + kRowStride_ * kScreenHeight_, 0xFF);
+        shadow_valid_ = true;
+    }
+}
+
+void SharpMipDisplay::PostTransferJob(TransferJob::Type type, const uint32_t rows[])
+{
+    TransferJob job;
+    job.type = type;
+    if(rows != nullptr)
+    {
+        std::copy(rows, rows + kRowBitmapWords_, job.rows);
+    }
+    while(!pipeline_queue_->TryPush(job))
+    {
+        // Queue is full, core 1 is still sending older jobs
+        tight_loop_contents();
+    }
+    __sev();
+}
+
+void SharpMipDisplay::Core1Entry()
+{
+    SharpMipDisplay* display = reinterpret_cast<SharpMipDisplay*>(multicore_fifo_pop_blocking());
+    display->RunPipeline();
+}
+
+void SharpMipDisplay::RunPipeline()
+{
+    TransferJob job;
+    while(true)
+    {
+        pipeline_active_ = true;
+        while(pipeline_queue_->TryPop(job))
+        {
+            if(job.type == TransferJob::Type::kLines)
+            {
+                TransmitLines(job.rows);
+            }
+            else if(job.type == TransferJob::Type::kClear)
+            {
+                TransmitClear();
+            }
+            else
+            {
+                TransmitVcom();
+            }
+        }
+        if(vcom_requested_.exchange(false))
+        {
+            TransmitVcom();
+            // Sent for the timer, so the next tick is not skipped like after a refresh
+            vcom_toggled_ = false;
+        }
+        pipeline_active_ = false;
+        // Core 0 sends an event after every new job, so a job posted after the last TryPop() wakes core 1 immediately
+        __wfe();
+    }
+}
+
+template <uint8_t kWidthInBytes>
+void SharpMipDisplay::DrawLineOfTextFixed(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
+{
+    uint8_t char_height_in_pixels = font[1];
+    uint8_t first_char_in_fonts = font[2];
+    uint16_t char_size_in_bytes = kWidthInBytes * char_height_in_pixels;
+    if(y >= kScreenHeight_)
+    {
+        return;
+    }
+    uint8_t rows_to_draw = std::min<uint16_t>(char_height_in_pixels, kScreenHeight_ - y);
+
+    uint8_t* destination = RowPointer(y) + x;
+    uint16_t col{x};
+    for(const auto& character : new_string)     // iterate through every char in string
+    {
+        if(col + kWidthInBytes > kScreenWidthInWords_)
+        {
+            break;
+        }
+        const uint8_t* glyph = &font[(character - first_char_in_fonts)*char_size_in_bytes + 3];
+        if(mode == Mode::kAdd)
+        {
+            GlyphBlitter<kWidthInBytes>::And(destination, kRowStride_, glyph, rows_to_draw);
+        }
+        else
+        {
+            GlyphBlitter<kWidthInBytes>::Copy(destination, kRowStride_, glyph, rows_to_draw);
+        }
+        destination += kWidthInBytes;
+        col += kWidthInBytes;
+    }
+
+    if(mode == Mode::kReplace)
+    {
+        EraseRestOfRows(col, y, rows_to_draw);
+    }
+}
+
+template <uint8_t kWidthInBytes>
+void SharpMipDisplay::DrawLineOfTextCompressed(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
+{
+    uint8_t char_height_in_pixels = font[1];
+    if(y >= kScreenHeight_)
+    {
+        return;
+    }
+    uint8_t rows_to_draw = std::min<uint16_t>(char_height_in_pixels, kScreenHeight_ - y);
+
+    uint8_t* destination = RowPointer(y) + x;
+    uint16_t col{x};
+    for(const auto& character : new_string)     // iterate through every char in string
+    {
+        if(col + kWidthInBytes > kScreenWidthInWords_)
+        {
+            break;
+        }
+        // Rows are decoded straight into the screen buffer
+        GlyphReader glyph(font, character);
+        uint8_t* row = destination;
+        for(uint8_t j = 0; j < rows_to_draw; ++j)
+        {
+            const uint8_t* glyph_row = glyph.NextRow();
+            if(glyph_row == nullptr)
+            {
+                // White row does not change anything in Mode::kAdd
+                if(mode != Mode::kAdd)
+                {
+                    GlyphBlitter<kWidthInBytes>::WhiteRow(row);
+                }
+            }
+            else if(mode == Mode::kAdd)
+            {
+                GlyphBlitter<kWidthInBytes>::AndRow(row, glyph_row);
+            }
+            else
+            {
+                GlyphBlitter<kWidthInBytes>::CopyRow(row, glyph_row);
+            }
+            row += kRowStride_;
+        }
+        destination += kWidthInBytes;
+        col += kWidthInBytes;
+    }
+
+    if(mode == Mode::kReplace)
+    {
+        EraseRestOfRows(col, y, rows_to_draw);
+    }
+}
+
+template <uint8_t kWidthInBytes>
+void SharpMipDisplay::DrawLineOfTextShifted(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
+{
+    uint8_t char_height_in_pixels = font[1];
+    if(y >= kScreenHeight_ || x >= kScreenWidth_)
+    {
+        return;
+    }
+    if(IsCompressedFont(font))
+    {
+        DrawLineOfTextShiftedByGlyph<kWidthInBytes>(x, y, new_string, font, mode);
+        return;
+    }
+    uint8_t rows_to_draw = std::min<uint16_t>(char_height_in_pixels, kScreenHeight_ - y);
+
+    // Shifted text covers one byte more than the glyphs, so the last glyph has to end before the last byte of the row.
+    // Runs of characters are drawn one after another, each one takes the pixels shifted out of the previous run
+    // from its first byte, the same as the pixels left of the text.
+    const uint16_t col = x / 8;
+    const uint8_t shift = x % 8;
+    const uint8_t amount_of_chars = std::min<size_t>(new_string.size(), (kScreenWidthInWords_ - col - 1) / kWidthInBytes);
+    const uint8_t* glyphs[kShiftedRunLength_];
+    uint8_t run_start{0};
+    do
+    {
+        const uint8_t run_length = std::min<uint8_t>(kShiftedRunLength_, amount_of_chars - run_start);
+        for(uint8_t i = 0; i < run_length; ++i)
+        {
+            glyphs[i] = &font[kRawFontHeaderSize + (new_string[run_start + i] - font[2]) * kWidthInBytes * char_height_in_pixels];
+        }
+        MergeShiftedRun<kWidthInBytes>(RowPointer(y) + col + run_start * kWidthInBytes, glyphs, run_length, rows_to_draw, shift, mode);
+        run_start += run_length;
+    }
+    while(run_start < amount_of_chars);
+
+    if(mode == Mode::kReplace)
+    {
+        EraseRestOfRows(col + amount_of_chars * kWidthInBytes + 1, y, rows_to_draw);
+    }
+}
+
+template <uint8_t kWidthInBytes>
+void SharpMipDisplay::MergeShiftedRun(uint8_t* destination, const uint8_t* const glyphs[], uint8_t amount_of_chars, uint8_t rows_to_draw,
+                                      uint8_t shift, Mode mode)
+{
+    switch(mode)
+    {
+    case Mode::kAdd:
+        MergeShiftedRun<kWidthInBytes, Mode::kAdd>(destination, glyphs, amount_of_chars, rows_to_draw, shift);
+        break;
+    case Mode::kMix:
+        MergeShiftedRun<kWidthInBytes, Mode::kMix>(destination, glyphs, amount_of_chars, rows_to_draw, shift);
+        break;
+    default:
+        MergeShiftedRun<kWidthInBytes, Mode::kReplace>(destination, glyphs, amount_of_chars, rows_to_draw, shift);
+        break;
+    }
+}
+
+template <uint8_t kWidthInBytes, SharpMipDisplay::Mode kMode>
+void SharpMipDisplay::MergeShiftedRun(uint8_t* destination, const uint8_t* const glyphs[], uint8_t amount_of_chars, uint8_t rows_to_draw,
+                                      uint8_t shift)
+{
+    // As many rows as fit into two TextWords are merged at once, then one TextWord, the remaining rows one by one
+    // Stores to the screen buffer could change kRowStride_ as far as the compiler knows, it is read once
+    constexpr uint8_t kRows = sizeof(TextWord) / kWidthInBytes;
+    const size_t row_stride = kRowStride_;
+    uint8_t j{0};
+    for(; j + 2 * kRows <= rows_to_draw; j += 2 * kRows)
+    {
+        MergeShiftedRows<kWidthInBytes, kRows, 2, kMode>(destination + j * row_stride, row_stride, glyphs, amount_of_chars, j * kWidthInBytes, shift);
+    }
+    if(j + kRows <= rows_to_draw)
+    {
+        MergeShiftedRows<kWidthInBytes, kRows, 1, kMode>(destination + j * row_stride, row_stride, glyphs, amount_of_chars, j * kWidthInBytes, shift);
+        j += kRows;
+    }
+    for(; j < rows_to_draw; ++j)
+    {
+        MergeShiftedRows<kWidthInBytes, 1, 1, kMode>(destination + j * row_stride, row_stride, glyphs, amount_of_chars, j * kWidthInBytes, shift);
+    }
+}
+
+template <uint8_t kWidthInBytes, uint8_t kRows, uint8_t kWords, SharpMipDisplay::Mode kMode>
+void SharpMipDisplay::MergeShiftedRows(uint8_t* destination, size_t row_stride, const uint8_t* const glyphs[], uint8_t amount_of_chars,
+                                       size_t glyph_offset, uint8_t shift)
+{
+    // Rows of a glyph follow each other in the font, kRows of them are loaded into one word. Every row is a lane
+    // of kLaneBits from the top of the word, lanes are shifted together and masks keep pixels in their own row.
+    constexpr uint8_t kWordBits = 8 * sizeof(TextWord);
+    constexpr uint8_t kLaneBits = 8 * kWidthInBytes;
+    const uint8_t left_mask = static_cast<uint8_t>(0xFF << (8 - shift));
+    const uint8_t right_mask = static_cast<uint8_t>(~left_mask);
+
+    TextWord lane_tops{0};
+    #pragma GCC unroll 8
+    for(uint8_t r = 0; r < kRows; ++r)
+    {
+        lane_tops |= static_cast<TextWord>(left_mask) << (kWordBits - 8 - r * kLaneBits);
+    }
+
+    // Pixels shifted out of the previous glyph at the top of every lane, before the first one they are the pixels left of the text.
+    // Rows 3 bytes wide are stored as 4 bytes and overwrite the last byte before it is merged, its pixels right of the text are kept.
+    constexpr bool kOverwritesLastByte = (kWidthInBytes == 3 && kMode == Mode::kMix);
+    uint8_t* const last_bytes = destination + amount_of_chars * kWidthInBytes;
+    TextWord carries[kWords]{};
+    uint8_t right_of_text[kWords * kRows];
+    #pragma GCC unroll 16
+    for(uint8_t r = 0; r < kWords * kRows; ++r)
+    {
+        const uint8_t background = (kMode == Mode::kAdd) ? left_mask : destination[r * row_stride] & left_mask;
+        carries[r / kRows] |= static_cast<TextWord>(background) << (kWordBits - 8 - r % kRows * kLaneBits);
+        if(kOverwritesLastByte)
+        {
+            right_of_text[r] = last_bytes[r * row_stride] & right_mask;
+        }
+    }
+
+    uint8_t* pixels = destination;
+    #pragma GCC unroll 2
+    for(uint8_t i = 0; i < amount_of_chars; ++i)
+    {
+        // Stores to the screen buffer could change glyphs[] as far as the compiler knows, the pointer is read once
+        const uint8_t* const glyph = glyphs[i] + glyph_offset;
+        #pragma GCC unroll 2
+        for(uint8_t w = 0; w < kWords; ++w)
+        {
+            const TextWord glyph_rows = LoadGlyphRows<kWidthInBytes, kRows>(glyph + w * kRows * kWidthInBytes);
+            TextWord& carry = carries[w];
+            TextWord shifted_rows;
+            if(kRows * kLaneBits == kWordBits)
+            {
+                // Lanes fill the word, one rotation moves the pixels shifted out of every lane to the top of the next one. They are
+                // taken out with XOR, the carry has pixels only where they were.
+                const TextWord rotated_rows = (glyph_rows >> shift) | (glyph_rows << ((kWordBits - shift) & (kWordBits - 1)));
+                const TextWord shifted_out = rotated_rows & lane_tops;
+                shifted_rows = rotated_rows ^ shifted_out ^ carry;
+                carry = (shifted_out << (kLaneBits % kWordBits)) | (shifted_out >> ((kWordBits - kLaneBits) % kWordBits));
+            }
+            else
+            {
+                // Pixels shifted out of every lane land at the top of the lane below it, or below the last lane
+                const TextWord moved_rows = glyph_rows >> shift;
+                shifted_rows = (moved_rows & ~lane_tops) | carry;
+                carry = (moved_rows & (lane_tops >> (kLaneBits % kWordBits))) << (kLaneBits % kWordBits);
+            }
+
+            uint8_t* rows = pixels + w * kRows * row_stride;
+            if(kMode == Mode::kAdd)
+            {
+                #pragma GCC unroll 8
+                for(uint8_t r = 0; r < kRows; ++r)
+                {
+                    uint8_t* row = rows + r * row_stride;
+                    const uint32_t shifted_row = static_cast<uint32_t>((shifted_rows << (r * kLaneBits % kWordBits)) >> (kWordBits - 32));
+                    StoreBigEndian<kWidthInBytes>(row, LoadBigEndian<kWidthInBytes>(row) & shifted_row);
+                }
+            }
+            else
+            {
+                // Swapped once, the bytes of every lane follow each other from the bottom of the word. Rows 3 bytes wide are stored
+                // as 4 bytes, the next glyph or the last byte overwrites the fourth one.
+                constexpr uint8_t kStoredBytes = (kWidthInBytes == 3) ? 4 : kWidthInBytes;
+                const TextWord swapped_rows = (sizeof(TextWord) == 8) ? __builtin_bswap64(shifted_rows) : __builtin_bswap32(shifted_rows);
+                #pragma GCC unroll 8
+                for(uint8_t r = 0; r < kRows; ++r)
+                {
+                    const TextWord lane = swapped_rows >> (r * kLaneBits % kWordBits);
+                    std::memcpy(rows + r * row_stride, &lane, kStoredBytes);
+                }
+            }
+        }
+        pixels += kWidthInBytes;
+    }
+
+    // Pixels shifted out of the last glyph, the rest of the byte is kept, or erased with Mode::kReplace
+    #pragma GCC unroll 16
+    for(uint8_t r = 0; r < kWords * kRows; ++r)
+    {
+        uint8_t& last_byte = last_bytes[r * row_stride];
+        const uint8_t last_pixels = static_cast<uint8_t>(carries[r / kRows] >> (kWordBits - 8 - r % kRows * kLaneBits));
+        if(kMode == Mode::kAdd)
+        {
+            last_byte &= last_pixels | right_mask;
+        }
+        else if(kMode == Mode::kMix)
+        {
+            last_byte = last_pixels | (kOverwritesLastByte ? right_of_text[r] : last_byte & right_mask);
+        }
+        else
+        {
+            last_byte = last_pixels | right_mask;
+        }
+    }
+}
+
+template <uint8_t kWidthInBytes>
+void SharpMipDisplay::DrawLineOfTextShiftedByGlyph(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
+{
+    uint8_t char_height_in_pixels = font[1];
+    uint8_t rows_to_draw = std::min<uint16_t>(char_height_in_pixels, kScreenHeight_ - y);
+
+    // A glyph row shifted right by 1-7 pixels covers one byte more than the glyph. Glyphs are stored whole, each one
+    // completes the bytes of the previous one: carry keeps the pixels which were shifted out of the previous glyph 
+    // in every row. Before the first glyph they are the pixels left of the text, so only the last byte is merged.
+    const uint8_t shift = x % 8;
+    const uint8_t left_mask = static_cast<uint8_t>(0xFF << (8 - shift));
+    uint8_t carry[UINT8_MAX];
+    uint8_t* const first_byte = RowPointer(y) + x / 8;
+    for(uint8_t j = 0; j < rows_to_draw; ++j)
+    {
+        carry[j] = (mode == Mode::kAdd) ? left_mask : first_byte[j * kRowStride_] & left_mask;
+    }
+
+    uint16_t col = x / 8;
+    for(const auto& character : new_string)     // iterate through every char in string
+    {
+        if(col + kWidthInBytes + 1 > kScreenWidthInWords_)
+        {
+            break;
+        }
+        uint8_t* destination = RowPointer(y) + col;
+        // Cached glyph rows are already shifted, kWidthInBytes + 1 bytes each
+        const uint8_t* shifted_glyph_rows = (glyph_cache_ != nullptr) ? glyph_cache_->Get(font, character, shift) : nullptr;
+        if(shifted_glyph_rows != nullptr)
+        {
+            // Pixels shifted in from outside of the cell are white in the cache, the carry replaces them
+            auto next_row = [shifted_glyph_rows, shift, left_mask](uint32_t& shifted_glyph, uint8_t& spill) mutable
+            {
+                shifted_glyph = LoadBigEndian<kWidthInBytes>(shifted_glyph_rows) & (UINT32_MAX >> shift);
+                spill = shifted_glyph_rows[kWidthInBytes] & left_mask;
+                shifted_glyph_rows += kWidthInBytes + 1;
+            };
+            MergeShiftedGlyph<kWidthInBytes>(destination, rows_to_draw, carry, mode, next_row);
+        }
+        else
+        {
+            GlyphReader glyph(font, character);
+            auto next_row = [glyph, shift](uint32_t& shifted_glyph, uint8_t& spill) mutable
+            {
+                constexpr uint32_t kCellMask = UINT32_MAX << (32 - 8 * kWidthInBytes);
+                const uint8_t* glyph_row_bytes = glyph.NextRow();
+                uint32_t glyph_row = (glyph_row_bytes != nullptr) ? LoadBigEndian<kWidthInBytes>(glyph_row_bytes) : kCellMask;
+                shifted_glyph = glyph_row >> shift;
+                spill = static_cast<uint8_t>(glyph_row >> (32 - 8 * kWidthInBytes) << (8 - shift));
+            };
+            MergeShiftedGlyph<kWidthInBytes>(destination, rows_to_draw, carry, mode, next_row);
+        }
+        col += kWidthInBytes;
+    }
+
+    // Pixels shifted out of the last glyph, the rest of the byte is kept, or erased with Mode::kReplace
+    const uint8_t right_mask = static_cast<uint8_t>(~left_mask);
+    uint8_t* last_byte = RowPointer(y) + col;
+    for(uint8_t j = 0; j < rows_to_draw && col < kScreenWidthInWords_; ++j)
+    {
+        if(mode == Mode::kAdd)
+        {
+            *last_byte &= carry[j] | right_mask;
+        }
+        else if(mode == Mode::kMix)
+        {
+            *last_byte = carry[j] | (*last_byte & right_mask);
+        }
+        else
+        {
+            *last_byte = carry[j] | right_mask;
+        }
+        last_byte += kRowStride_;
+    }
+    if(mode == Mode::kReplace)
+    {
+        EraseRestOfRows(col + 1, y, rows_to_draw);
+    }
+}
+
+template <uint8_t kWidthInBytes, typename NextRow>
+void SharpMipDisplay::MergeShiftedGlyph(uint8_t* destination, uint8_t rows_to_draw, uint8_t carry[], Mode mode, NextRow next_row)
+{
+    // Row source and stride are locals, so stores to the screen buffer do not force reloading them
+    const size_t row_stride = kRowStride_;
+    uint32_t shifted_glyph;
+    uint8_t spill;
+    if(mode == Mode::kAdd)
+    {
+        for(uint8_t j = 0; j < rows_to_draw; ++j)
+        {
+            next_row(shifted_glyph, spill);
+            uint32_t pixels = shifted_glyph | (static_cast<uint32_t>(carry[j]) << 24);
+            StoreBigEndian<kWidthInBytes>(destination, LoadBigEndian<kWidthInBytes>(destination) & pixels);
+            carry[j] = spill;
+            destination += row_stride;
+        }
+        return;
+    }
+    for(uint8_t j = 0; j < rows_to_draw; ++j)
+    {
+        next_row(shifted_glyph, spill);
+        StoreBigEndian<kWidthInBytes>(destination, shifted_glyph | (static_cast<uint32_t>(carry[j]) << 24));
+        carry[j] = spill;
+        destination += row_stride;
+    }
+}
+
+void SharpMipDisplay::DrawLineOfTextGeneric(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
+{
+    uint8_t char_width_in_bytes = FontWidthInBytes(font);
+    uint8_t char_height_in_pixels = font[1];
+    if(y >= kScreenHeight_)
+    {
+        return;
+    }
+    uint8_t rows_to_draw = std::min<uint16_t>(char_height_in_pixels, kScreenHeight_ - y);
+
+    uint16_t col{x};
+    for(const auto& character : new_string)     // iterate through every char in string
+    {
+        if(col + char_width_in_bytes > kScreenWidthInWords_)
+        {
+            break;
+        }
+        GlyphReader glyph(font, character);
+        for(std::size_t j = 0; j < rows_to_draw; ++j)  //iterate vertically through every line in a char
+        {
+            uint8_t* row = RowPointer(y + j) + col;
+            const uint8_t* glyph_row = glyph.NextRow();
+            for(std::size_t i = 0; i < char_width_in_bytes; ++i)
+            {
+                uint8_t pixels = (glyph_row != nullptr) ? glyph_row[i] : 0b11111111;
+                if(mode == Mode::kAdd)
+                {
+                    row[i] &= pixels;
+                }
+                else
+                {
+                    row[i] = pixels;
+                }
+            }
+        }
+        col += char_width_in_bytes;
+    }
+
+    if(mode == Mode::kReplace)
+    {
+        EraseRestOfRows(col, y, rows_to_draw);
+    }
+}
+
+void SharpMipDisplay::DrawLineOfTextProportional(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode)
+{
+    uint8_t char_height_in_pixels = font[1];
+    if(y >= kScreenHeight_)
+    {
+        return;
+    }
+    uint8_t rows_to_draw = std::min<uint16_t>(char_height_in_pixels, kScreenHeight_ - y);
+
+    // Find glyphs which fit into the row and the end of the text
+    int text_end{x};
+    size_t amount_of_chars{0};
+    for(; amount_of_chars < new_string.size(); ++amount_of_chars)
+    {
+        int position{text_end};
+        if(amount_of_chars > 0)
+        {
+            position += KerningAdjustment(font, new_string[amount_of_chars - 1], new_string[amount_of_chars]);
+        }
+        position = std::max(position, 0);
+        int advance = ProportionalGlyphAdvance(font, new_string[amount_of_chars]);
+        if(position + advance > kScreenWidth_)
+        {
+            break;
+        }
+        text_end = position + advance;
+    }
+
+    // Kerned glyphs may overlap, so the text area is erased once and every glyph is merged into it
+    if(mode == Mode::kReplace)
+    {
+        ApplySpan(x, kScreenWidth_, y, rows_to_draw, PixelOp::kClear);
+    }
+    else if(mode == Mode::kMix)
+    {
+        ApplySpan(x, text_end, y, rows_to_draw, PixelOp::kClear);
+    }
+
+    int position{x};
+    for(size_t c = 0; c < amount_of_chars; ++c)
+    {
+        const char character = new_string[c];
+        if(c > 0)
+        {
+            position = std::max(position + KerningAdjustment(font, new_string[c - 1], character), 0);
+        }
+        const uint8_t advance = ProportionalGlyphAdvance(font, character);
+        const uint8_t glyph_width_in_bytes = (advance + 7) / 8;
+        const uint8_t* glyph = ProportionalGlyphRows(font, character);
+        const uint8_t shift = position % 8;
+        const uint16_t col = position / 8;
+        // A shifted glyph row covers one byte more, which is only white spacing if it is outside of the screen
+        const uint16_t col_end = std::min<uint16_t>(col + glyph_width_in_bytes + (shift != 0 ? 1 : 0), kScreenWidthInWords_);
+        for(uint8_t j = 0; j < rows_to_draw; ++j)
+        {
+            uint8_t* row = RowPointer(y + j);
+            uint8_t previous{0b11111111};
+            for(uint16_t i = col; i < col_end; ++i)
+            {
+                uint8_t pixels = (i - col < glyph_width_in_bytes) ? glyph[i - col] : 0b11111111;
+                row[i] &= (previous << (8 - shift)) | (pixels >> shift);
+                previous = pixels;
+            }
+            glyph += glyph_width_in_bytes;
+        }
+        position += advance;
+    }
+}
+
+void SharpMipDisplay::ApplySpan(uint16_t x_start, uint16_t x_end, uint16_t y, uint16_t amount_of_rows, PixelOp op)
+{
+    if(x_start >= x_end)
+    {
+        return;
+    }
+    const uint16_t first_byte = x_start / 8;
+    const uint16_t last_byte = (x_end - 1) / 8;
+    uint8_t first_mask = 0b11111111 >> (x_start % 8);
+    uint8_t last_mask = 0b11111111 << (7 - (x_end - 1) % 8);
+    if(first_byte == last_byte)
+    {
+        first_mask &= last_mask;
+    }
+    for(uint16_t j = 0; j < amount_of_rows; ++j)
+    {
+        uint8_t* row = RowPointer(y + j);
+        ApplyMask(row[first_byte], first_mask, op);
+        if(last_byte > first_byte)
+        {
+            ApplyToBytes(row + first_byte + 1, row + last_byte, op);
+            ApplyMask(row[last_byte], last_mask, op);
+        }
+    }
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::ApplyRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, PixelOp op)
+{
+    if(x >= kScreenWidth_ || y >= kScreenHeight_ || width == 0 || height == 0)
+    {
+        return LineRange{0, 0};
+    }
+    const uint16_t x_end = std::min<uint32_t>(x + width, kScreenWidth_);
+    const uint16_t y_end = std::min<uint32_t>(y + height, kScreenHeight_);
+    ApplySpan(x, x_end, y, y_end - y, op);
+    MarkRowsDirty(y, y_end);
+    return LineRange{static_cast<uint8_t>(y), static_cast<uint8_t>(y_end)};
+}
+
+void SharpMipDisplay::ApplyColumnMasks(const uint8_t byte_indexes[], const uint8_t masks[], size_t amount_of_bytes, uint16_t y_first,
+                                       uint16_t y_last, PixelOp op)
+{
+    // Every operation as (pixels & keep) ^ flip, so the loop over rows does not depend on it
+    uint8_t keep[kMaxSegmentBytes_];
+    uint8_t flip[kMaxSegmentBytes_];
+    for(size_t i = 0; i < amount_of_bytes; ++i)
+    {
+        keep[i] = (op == PixelOp::kInvert) ? 0b11111111 : ~masks[i];
+        flip[i] = (op == PixelOp::kSet) ? 0 : masks[i];
+    }
+    uint8_t* row = RowPointer(y_first);
+    for(uint16_t y = y_first; y <= y_last; ++y)
+    {
+        for(size_t i = 0; i < amount_of_bytes; ++i)
+        {
+            row[byte_indexes[i]] = (row[byte_indexes[i]] & keep[i]) ^ flip[i];
+        }
+        row += kRowStride_;
+    }
+    MarkRowsDirty(y_first, y_last + 1);
+}
+
+uint32_t SharpMipDisplay::LoadBitmapWord(const uint8_t* row, int32_t byte, int32_t width_in_bytes, uint8_t shift)
+{
+    uint32_t word;
+    uint8_t next_byte;
+    if(byte >= 0 && byte + 4 < width_in_bytes)
+    {
+        word = LoadBigEndian<4>(row + byte);
+        next_byte = row[byte + 4];
+    }
+    else
+    {
+        word = 0;
+        for(int32_t i = 0; i < 4; ++i)
+        {
+            const int32_t index = byte + i;
+            const uint8_t pixels = (index >= 0 && index < width_in_bytes) ? row[index] : 0;
+            word |= static_cast<uint32_t>(pixels) << (24 - 8 * i);
+        }
+        next_byte = (byte + 4 < width_in_bytes) ? row[byte + 4] : 0;
+    }
+    return (word << shift) | (next_byte >> (8 - shift));
+}
+
+template <SharpMipDisplay::RasterOp kOp>
+void SharpMipDisplay::BlitBitmapRows(int16_t x, int16_t y, const uint8_t bitmap[], const uint8_t mask_bitmap[], uint16_t width,
+                                     uint16_t stride, int32_t x_start, int32_t x_end, int32_t y_start, int32_t y_end)
+{
+    const int32_t first_byte = x_start / 8;
+    const int32_t amount_of_bytes = (x_end - 1) / 8 - first_byte + 1;
+    const int32_t bitmap_width_in_bytes = (width + 7) / 8;
+
+    // Screen byte b starts at bitmap pixel 8 * b - x, so every screen word is made of 5 bitmap bytes shifted left by the same amount
+    const int32_t source_first_byte = FloorDiv(first_byte * 8 - x, 8);
+    const uint8_t shift = (first_byte * 8 - x) - source_first_byte * 8;
+    const uint32_t first_mask = UINT32_MAX >> (x_start % 8);
+    // Last word starts at a multiple of 4 bytes from the first one, the mask ends at the last pixel
+    const uint32_t last_mask = UINT32_MAX << (31 - (x_end - 1 - (first_byte + (amount_of_bytes - 1) / 4 * 4) * 8));
+
+    for(int32_t row = y_start; row < y_end; ++row)
+    {
+        const uint8_t* source = bitmap + static_cast<size_t>(row - y) * stride;
+        const uint8_t* mask_source = (mask_bitmap != nullptr) ? mask_bitmap + static_cast<size_t>(row - y) * stride : nullptr;
+        uint8_t* pixels = RowPointer(row) + first_byte;
+        int32_t source_byte = source_first_byte;
+        uint32_t mask = first_mask;
+        for(int32_t bytes_left = amount_of_bytes; bytes_left > 0; bytes_left -= 4, pixels += 4, source_byte += 4)
+        {
+            const uint32_t source_word = LoadBitmapWord(source, source_byte, bitmap_width_in_bytes, shift);
+            if(bytes_left <= 4)
+            {
+                mask &= last_mask;
+            }
+            if(mask_source != nullptr)
+            {
+                mask &= LoadBitmapWord(mask_source, source_byte, bitmap_width_in_bytes, shift);
+            }
+            if(bytes_left >= 4)
+            {
+                StoreBigEndian<4>(pixels, ApplyRasterOp(LoadBigEndian<4>(pixels), source_word, mask, kOp));
+            }
+            else
+            {
+                uint32_t word{0};
+                for(int32_t i = 0; i < bytes_left; ++i)
+                {
+                    word |= static_cast<uint32_t>(pixels[i]) << (24 - 8 * i);
+                }
+                word = ApplyRasterOp(word, source_word, mask, kOp);
+                for(int32_t i = 0; i < bytes_left; ++i)
+                {
+                    pixels[i] = static_cast<uint8_t>(word >> (24 - 8 * i));
+                }
+            }
+            mask = UINT32_MAX;
+        }
+    }
+}
+
+bool SharpMipDisplay::ApplyClippedSpan(int32_t x_first, int32_t x_last, int32_t y, PixelOp op, LineRange& dirty)
+{
+    if(x_first > x_last)
+    {
+        std::swap(x_first, x_last);
+    }
+    if(y < 0 || y >= kScreenHeight_ || x_last < 0 || x_first >= kScreenWidth_)
+    {
+        return false;
+    }
+    ApplySpan(std::max<int32_t>(x_first, 0), std::min<int32_t>(x_last + 1, kScreenWidth_), y, 1, op);
+    if(dirty.start == dirty.end)
+    {
+        dirty = LineRange{static_cast<uint8_t>(y), static_cast<uint8_t>(y + 1)};
+    }
+    else
+    {
+        dirty.start = std::min<int32_t>(dirty.start, y);
+        dirty.end = std::max<int32_t>(dirty.end, y + 1);
+    }
+    return true;
+}
+
+template <typename RowEdges>
+SharpMipDisplay::LineRange SharpMipDisplay::DrawRowSpans(int32_t y_first, int32_t y_last, bool filled, PixelOp op, RowEdges row_edges)
+{
+    LineRange dirty{0, 0};
+    const int32_t row_first = std::max<int32_t>(y_first, 0);
+    const int32_t row_last = std::min<int32_t>(y_last, kScreenHeight_ - 1);
+    if(row_first > row_last)
+    {
+        return dirty;
+    }
+    // Edges of the previous, current and next row
+    int32_t left[3] = {0, 0, 0};
+    int32_t right[3] = {0, 0, 0};
+    bool inside[3];
+    inside[0] = (row_first > y_first) && row_edges(row_first - 1, left[0], right[0]);
+    inside[1] = row_edges(row_first, left[1], right[1]);
+    for(int32_t row = row_first; row <= row_last; ++row)
+    {
+        inside[2] = (row < y_last) && row_edges(row + 1, left[2], right[2]);
+        if(inside[1])
+        {
+            // Pixels which have all 4 neighbours inside of the shape are not part of the outline
+            const int32_t interior_left = std::max({left[1] + 1, left[0], left[2]});
+            const int32_t interior_right = std::min({right[1] - 1, right[0], right[2]});
+            if(filled || !inside[0] || !inside[2] || interior_left > interior_right)
+            {
+                ApplyClippedSpan(left[1], right[1], row, op, dirty);
+            }
+            else
+            {
+                ApplyClippedSpan(left[1], interior_left - 1, row, op, dirty);
+                ApplyClippedSpan(interior_right + 1, right[1], row, op, dirty);
+            }
+        }
+        for(int i = 0; i < 2; ++i)
+        {
+            left[i] = left[i + 1];
+            right[i] = right[i + 1];
+            inside[i] = inside[i + 1];
+        }
+    }
+    MarkRowsDirty(dirty.start, dirty.end);
+    return dirty;
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, PixelOp op)
+{
+    // Corners of the rectangle around the line in 1/16 of a pixel. Its ends are half a pixel behind the end pixels, so they are covered.
+    // Offsets of the corners are the unit vector of the line scaled by 8 along it and by 8 * thickness across it, divided by its
+    // length, which is computed in 1/256 of a pixel.
+    constexpr int64_t kLengthScale{256};
+    const int64_t dx = x1 - x0;
+    const int64_t dy = y1 - y0;
+    const int64_t length = static_cast<int64_t>(SquareRoot(static_cast<uint64_t>(dx * dx + dy * dy) * kLengthScale * kLengthScale));
+    int32_t along_x{8};
+    int32_t along_y{0};
+    int32_t across_x{0};
+    int32_t across_y{8 * thickness};
+    if(length > 0)
+    {
+        along_x = RoundDiv(8 * dx * kLengthScale, length);
+        along_y = RoundDiv(8 * dy * kLengthScale, length);
+        across_x = RoundDiv(-8 * thickness * dy * kLengthScale, length);
+        across_y = RoundDiv(8 * thickness * dx * kLengthScale, length);
+    }
+    const int32_t corner_x[4] = {
+        x0 * 16 - along_x + across_x,
+        x1 * 16 + along_x + across_x,
+        x1 * 16 + along_x - across_x,
+        x0 * 16 - along_x - across_x
+    };
+    const int32_t corner_y[4] = {
+        y0 * 16 - along_y + across_y,
+        y1 * 16 + along_y + across_y,
+        y1 * 16 + along_y - across_y,
+        y0 * 16 - along_y - across_y
+    };
+    const int32_t top = *std::min_element(corner_y, corner_y + 4);
+    const int32_t bottom = *std::max_element(corner_y, corner_y + 4);
+
+    // Pixels whose centers are inside of the rectangle, edges at the left and top are included, at the right and bottom excluded
+    LineRange dirty{0, 0};
+    const int32_t row_first = std::max<int32_t>(CeilDiv(top, 16), 0);
+    const int32_t row_end = std::min<int32_t>(CeilDiv(bottom, 16), kScreenHeight_);
+    for(int32_t row = row_first; row < row_end; ++row)
+    {
+        const int32_t center_y = row * 16;
+        int32_t span_start = kUnlimited;
+        int32_t span_end = -kUnlimited;
+        for(int i = 0; i < 4; ++i)
+        {
+            const int j = (i + 1) % 4;
+            if((corner_y[i] <= center_y && center_y < corner_y[j]) || (corner_y[j] <= center_y && center_y < corner_y[i]))
+            {
+                const int64_t edge_height = corner_y[j] - corner_y[i];
+                const int64_t numerator = static_cast<int64_t>(corner_x[i]) * edge_height +
+                                          static_cast<int64_t>(center_y - corner_y[i]) * (corner_x[j] - corner_x[i]);
+                const int32_t edge_x = CeilDiv(numerator, edge_height * 16);
+                span_start = std::min(span_start, edge_x);
+                span_end = std::max(span_end, edge_x);
+            }
+        }
+        if(span_start < span_end)
+        {
+            ApplyClippedSpan(span_start, span_end - 1, row, op, dirty);
+        }
+    }
+    MarkRowsDirty(dirty.start, dirty.end);
+    return dirty;
+}
+
+SharpMipDisplay::LineRange SharpMipDisplay::DrawRing(int16_t x, int16_t y, uint16_t radius, int32_t inner_radius,
+                                                     uint16_t start_angle, uint16_t end_angle, PixelOp op)
+{
+    LineRange dirty{0, 0};
+    int32_t sweep = (static_cast<int32_t>(end_angle) - start_angle) % 360;
+    if(sweep < 0)
+    {
+        sweep += 360;
+    }
+    if(sweep == 0 && end_angle != start_angle)
+    {
+        sweep = 360;
+    }
+    if(sweep == 0)
+    {
+        return dirty;
+    }
+    // Directions of the ends, pixel (dx, dy) is clockwise from start if start_x * dy - start_y * dx >= 0
+    const int32_t start_x = CosineQ14(start_angle);
+    const int32_t start_y = SineQ14(start_angle);
+    const int32_t end_x = CosineQ14(end_angle);
+    const int32_t end_y = SineQ14(end_angle);
+
+    const int32_t row_first = std::max<int32_t>(y - radius, 0);
+    const int32_t row_last = std::min<int32_t>(y + radius, kScreenHeight_ - 1);
+    for(int32_t row = row_first; row <= row_last; ++row)
+    {
+        const int32_t dy = row - y;
+        const int32_t outer = EllipseHalfWidth(radius, radius, dy);
+        const int32_t inner = (inner_radius >= 0) ? EllipseHalfWidth(inner_radius, inner_radius, dy) : -1;
+        Span ring[2] = {{-outer, outer}, {1, 0}};
+        if(inner >= 0)
+        {
+            ring[0] = Span{-outer, -inner - 1};
+            ring[1] = Span{inner + 1, outer};
+        }
+
+        // Pixels of the row between the angles, as at most 2 separate spans
+        Span sector[2] = {{-kUnlimited, kUnlimited}, {1, 0}};
+        if(sweep < 360)
+        {
+            const Span after_start = HalfPlaneSpan(-start_y, start_x * dy);
+            const Span before_end = HalfPlaneSpan(end_y, -end_x * dy);
+            if(sweep <= 180)
+            {
+                sector[0] = Span{std::max(after_start.first, before_end.first), std::min(after_start.last, before_end.last)};
+            }
+            else
+            {
+                sector[0] = (after_start.first <= before_end.first) ? after_start : before_end;
+                sector[1] = (after_start.first <= before_end.first) ? before_end : after_start;
+                if(sector[0].first > sector[0].last)
+                {
+                    sector[0] = sector[1];
+                    sector[1] = Span{1, 0};
+                }
+                else if(sector[1].first <= sector[0].last + 1)
+                {
+                    sector[0].last = std::max(sector[0].last, sector[1].last);
+                    sector[1] = Span{1, 0};
+                }
+            }
+        }
+
+        for(const Span& ring_span : ring)
+        {
+            for(const Span& sector_span : sector)
+            {
+                const int32_t first = std::max(ring_span.first, sector_span.first);
+                const int32_t last = std::min(ring_span.last, sector_span.last);
+                if(first <= last)
+                {
+                    ApplyClippedSpan(x + first, x + last, row, op, dirty);
+                }
+            }
+        }
+    }
+    MarkRowsDirty(dirty.start, dirty.end);
+    return dirty;
+}
+
+void SharpMipDisplay::EraseRestOfRows(uint16_t x, uint16_t y, uint8_t amount_of_rows)
+{
+    // Erase ramaining cols, which are not filled with new text, up to the end of the row
+    if(x >= kScreenWidthInWords_)
+    {
+        return;
+    }
+    uint8_t blank_pixel{0b11111111};
+    for(std::size_t j = 0; j < amount_of_rows; ++j)
+    {
+        std::fill(RowPointer(y + j) + x, RowPointer(y + j) + kScreenWidthInWords_, blank_pixel);
     }
 }
 
@@ -2,18 +2,105 @@
 #define SHARP_MIP_DISPLAY_H
 
 
-#include <bitset>
-#include <algorithm> // for std::reverse
+#include <algorithm>
+#include <atomic>
+#include <cstring>
 #include "hardware/spi.h"
 #include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "pico/time.h"
+#include "pico/multicore.h"
 
 #include "../display.h"
+#include "spi_dma.h"
+#include "sharp_mip_timing.h"
+#include "spsc_queue.h"
+#include "glyph_blitter.h"
+#include "glyph_cache.h"
+#include "sprite.h"
+#include "font_format.h"
 
 class SharpMipDisplay : public Display
 {
 public:
 
-    SharpMipDisplay(uint16_t width, uint16_t height, spi_inst_t *spi, uint display_cs_pin);
+    /**
+     * @brief Layout of the screen buffer in memory.
+     *  - BufferLayout::kPacked: Rows contain only pixels. Blocking refreshes send every row together with its line address and trailer.
+     *    Asynchronous refreshes copy the rows into a packet, its buffer of (width / 8 + 2) * height + 2 bytes is allocated by EnableAsyncRefresh().
+     *  - BufferLayout::kWire: Every row is stored as it is sent to the screen: [line address][pixels][trailer]. Rows are sent directly 
+     *    from the screen buffer, without copying. Costs 2 bytes of RAM per row.
+     */
+    enum class BufferLayout{
+        kPacked,
+        kWire
+    };
+
+    /**
+     * @brief Range of rows, in PIXELS. The same convention as in RefreshScreen(): start is the first row, end is the row after the last one.
+     * 
+     */
+    struct LineRange
+    {
+        uint8_t start;
+        uint8_t end;
+    };
+
+    /**
+     * @brief Operation applied to pixels by area methods.
+     *  - PixelOp::kSet: pixels become black, like SetPixel().
+     *  - PixelOp::kClear: pixels become white, like ResetPixel().
+     *  - PixelOp::kInvert: black pixels become white and white become black.
+     */
+    enum class PixelOp{
+        kSet,
+        kClear,
+        kInvert
+    };
+
+    /**
+     * @brief Operation which combines pixels of a bitmap with the screen in BlitBitmap(). Bits are in the format of the screen buffer,
+     * 1 is white and 0 is black.
+     *  - RasterOp::kCopy: the bitmap replaces the screen.
+     *  - RasterOp::kAnd: black pixels of the bitmap are drawn, white are transparent.
+     *  - RasterOp::kOr: white pixels of the bitmap are drawn, black are transparent.
+     *  - RasterOp::kXor: white pixels of the bitmap invert the screen, black are transparent.
+     *  - RasterOp::kAndNot: white pixels of the bitmap are drawn black, black are transparent, i.e. a negative of kAnd.
+     */
+    enum class RasterOp{
+        kCopy,
+        kAnd,
+        kOr,
+        kXor,
+        kAndNot
+    };
+
+    /**
+     * @brief Horizontal line from column x0 to column x1, both included, in row y. Coordinates are in PIXELS.
+     * 
+     */
+    struct HorizontalSegment
+    {
+        uint16_t x0;
+        uint16_t x1;
+        uint16_t y;
+    };
+
+    // Lines are addressed with uint8_t, so 8 words of 32 bits are enough for a bitmap of every row of any supported screen
+    static constexpr uint8_t kRowBitmapWords_{8};
+
+    SharpMipDisplay(uint16_t width, uint16_t height, spi_inst_t *spi, uint display_cs_pin, BufferLayout layout = BufferLayout::kPacked);
+
+    /**
+     * @brief Waits for the transfer in progress, stops hardware VCOM and the pipeline on core 1 and frees all buffers owned by the display.
+     * 
+     */
+    ~SharpMipDisplay() override;
+
+    SharpMipDisplay(const SharpMipDisplay&) = delete;
+    SharpMipDisplay& operator=(const SharpMipDisplay&) = delete;
 
     /**
      * @brief Updates screen buffer (array) with given text. The text is put in the screen buffer at given position.
@@ -29,6 +116,27 @@ public:
      */
     void DrawLineOfText(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode = Mode::kReplace) override;
 
+    /**
+     * @brief The same as DrawLineOfText(), but x is in PIXELS, so text can start at any column. Every glyph row is shifted 
+     * across the byte boundary and merged with the screen buffer using edge masks, the pixels around the text are preserved.
+     * If x is a multiple of 8, the faster byte aligned DrawLineOfText() is used.
+     * 
+     * @param x column, in PIXELS. Position at which the text starts.
+     * @param y row, in PIXELS. Position at which the text starts.
+     * @param new_string string which needs to be put in screen buffer on given position.
+     * @param font Table with font which should be used. 
+     * @param mode The rendering mode, the same as in DrawLineOfText().
+     */
+    void DrawLineOfTextAtPixel(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode = Mode::kReplace);
+
+    /**
+     * @brief Returns width of the text in PIXELS, including advances and kerning of proportional fonts.
+     * 
+     * @param text string to measure.
+     * @param font Table with font, in any format.
+     */
+    static uint16_t GetTextWidth(const std::string& text, const uint8_t font[]);
+
     /**
      * @brief Draws a horizontal line. This method operates on full bytes, not on pixels also requires to redraw only 1 line of the screen, hence has very good performance
      * 
@@ -37,7 +145,8 @@ public:
     virtual void DrawHorizontalLine(uint16_t x) override;
 
     /**
-     * @brief Draws a vertical line. This method requires to redraw full display, hence is computation expensive.
+     * @brief Draws a vertical line over the full height of the screen, see DrawVerticalSegment(). It marks all rows as dirty,
+     * so the next Flush() sends the whole screen.
      * 
      * @param y column, in PIXELS
      */
@@ -59,6 +168,201 @@ public:
      */
     virtual void ResetPixel(uint16_t x, uint16_t y) override;
 
+    /**
+     * @brief Makes all pixels of the rectangle black. Rows are written with edge masks and 32-bit stores between them.
+     * The rectangle is clipped to the screen.
+     * 
+     * @param x column of the left edge, in PIXELS
+     * @param y row of the top edge, in PIXELS
+     * @param width width, in PIXELS
+     * @param height height, in PIXELS
+     * @return rows changed by the call, they are also marked for the next Flush(). Empty if the rectangle is outside of the screen.
+     */
+    LineRange FillRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+    /**
+     * @brief Makes all pixels of the rectangle white, e.g. to erase a value before it is redrawn. The same as FillRect() otherwise.
+     * 
+     */
+    LineRange ClearRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+    /**
+     * @brief Inverts all pixels of the rectangle, e.g. to highlight a selected item. The same as FillRect() otherwise.
+     * 
+     */
+    LineRange InvertRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height);
+
+    /**
+     * @brief Draws a 1 bit per pixel bitmap, e.g. an icon or a logo, at any pixel position. Rows of the bitmap have the format
+     * of the screen buffer: leftmost pixel in the MSB, 1 is white. Bitmap bytes are shifted to the screen bytes in 32-bit words,
+     * 4 screen bytes at once, and the bitmap is clipped to the screen.
+     * 
+     * @param x column of the left edge, in PIXELS
+     * @param y row of the top edge, in PIXELS
+     * @param bitmap rows of the bitmap, stride bytes apart
+     * @param width width of the bitmap, in PIXELS
+     * @param height height of the bitmap, in PIXELS
+     * @param stride distance between rows of the bitmap, in BYTES, at least (width + 7) / 8
+     * @param op how pixels of the bitmap are combined with the screen
+     * @return rows changed by the call, they are also marked for the next Flush(). Empty if the bitmap is outside of the screen.
+     */
+    LineRange BlitBitmap(int16_t x, int16_t y, const uint8_t bitmap[], uint16_t width, uint16_t height, uint16_t stride,
+                         RasterOp op = RasterOp::kCopy);
+
+    /**
+     * @brief Draws the sprite with its top left corner at (x, y). The screen bytes below it are saved first. If the sprite is already
+     * visible, its old background is restored before, so moving a sprite changes only the rows of its old and new position.
+     * The sprite is clipped to the screen.
+     * 
+     * @param sprite sprite to draw
+     * @param x column of the left edge, in PIXELS
+     * @param y row of the top edge, in PIXELS
+     * @return range from the first to the last changed row. Only rows of the old and the new position are marked for the next Flush().
+     */
+    LineRange DrawSprite(Sprite& sprite, int16_t x, int16_t y);
+
+    /**
+     * @brief Restores the background of a visible sprite. Nothing is changed if the sprite is not visible.
+     * 
+     * @return rows changed by the call, they are also marked for the next Flush().
+     */
+    LineRange HideSprite(Sprite& sprite);
+
+    /**
+     * @brief Draws a horizontal line from column x0 to column x1, both included, in any order, e.g. an underline or a bar of a chart.
+     * Bytes at the ends are written with masks, whole bytes and 32-bit words between them. Columns outside of the screen are skipped.
+     * 
+     * @param x0 first column, in PIXELS
+     * @param x1 last column, in PIXELS
+     * @param y row, in PIXELS
+     * @param op operation applied to the pixels of the line
+     * @return rows changed by the call, they are also marked for the next Flush(). Empty if the line is outside of the screen.
+     */
+    LineRange DrawHorizontalSegment(uint16_t x0, uint16_t x1, uint16_t y, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws many horizontal lines, e.g. spans produced by a polygon or chart renderer. Only rows of the lines are marked
+     * as dirty, rows between them are not. With PixelOp::kInvert overlapping lines invert their common pixels twice.
+     * 
+     * @param segments lines to draw, in any order
+     * @param amount_of_segments number of items in segments
+     * @param op operation applied to the pixels of all lines
+     * @return range from the first to the last changed row. Empty if all lines are outside of the screen.
+     */
+    LineRange DrawHorizontalSegments(const HorizontalSegment segments[], size_t amount_of_segments, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws a vertical line from row y0 to row y1, both included, in any order. The byte and the mask of the column are computed
+     * once, then the screen buffer is walked by the row stride. Rows outside of the screen are skipped.
+     * 
+     * @param x column, in PIXELS
+     * @param y0 first row, in PIXELS
+     * @param y1 last row, in PIXELS
+     * @param op operation applied to the pixels of the line
+     * @return rows changed by the call, they are also marked for the next Flush(). Empty if the column is outside of the screen.
+     */
+    LineRange DrawVerticalSegment(uint16_t x, uint16_t y0, uint16_t y1, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws vertical lines in several columns from row y0 to row y1, e.g. the rules of a table. Masks of columns which share a byte
+     * are merged, so every row is walked once and each byte is written once per row. Columns may be given in any order,
+     * columns outside of the screen are skipped. With PixelOp::kInvert a column given twice is inverted twice.
+     * The same as DrawVerticalSegment() otherwise.
+     * 
+     * @param columns columns of the lines, in PIXELS
+     * @param amount_of_columns number of items in columns
+     */
+    LineRange DrawVerticalSegments(const uint16_t columns[], size_t amount_of_columns, uint16_t y0, uint16_t y1,
+                                   PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws a line between two pixels, both included. Lines which are 1 pixel thick are drawn with Bresenham's algorithm,
+     * one span per row. Thicker lines are filled as a rectangle around the line, row by row.
+     * Shapes may be partly outside of the screen, they are clipped. Every pixel of a shape is changed once, so PixelOp::kInvert
+     * can be used to draw and later erase a shape over other content.
+     * 
+     * @param x0 column of the first end, in PIXELS
+     * @param y0 row of the first end, in PIXELS
+     * @param x1 column of the second end, in PIXELS
+     * @param y1 row of the second end, in PIXELS
+     * @param thickness width of the line, in PIXELS
+     * @param op operation applied to the pixels of the line
+     * @return rows changed by the call, they are also marked for the next Flush(). Empty if the line is outside of the screen.
+     */
+    LineRange DrawLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness = 1, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws the outline of a circle. The same as DrawEllipse() with both radii equal.
+     * 
+     */
+    LineRange DrawCircle(int16_t x, int16_t y, uint16_t radius, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws a filled circle. The same as FillEllipse() with both radii equal.
+     * 
+     */
+    LineRange FillCircle(int16_t x, int16_t y, uint16_t radius, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws the outline of an ellipse. The outline is made of the pixels of the filled ellipse which have a neighbour
+     * outside of it, so it is 1 pixel thick and has no gaps.
+     * 
+     * @param x column of the center, in PIXELS
+     * @param y row of the center, in PIXELS
+     * @param radius_x horizontal radius, in PIXELS. The ellipse is 2 * radius_x + 1 pixels wide.
+     * @param radius_y vertical radius, in PIXELS. The ellipse is 2 * radius_y + 1 pixels high.
+     * @param op operation applied to the pixels of the outline
+     * @return rows changed by the call, they are also marked for the next Flush()
+     */
+    LineRange DrawEllipse(int16_t x, int16_t y, uint16_t radius_x, uint16_t radius_y, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws a filled ellipse as one span per row. The same as DrawEllipse() otherwise.
+     * 
+     */
+    LineRange FillEllipse(int16_t x, int16_t y, uint16_t radius_x, uint16_t radius_y, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws an arc of a circle, e.g. the scale of a gauge. Angles are in degrees, 0 points right and they grow clockwise.
+     * The arc goes clockwise from start_angle to end_angle, so (0, 360) is the whole ring and (300, 60) crosses 0.
+     * 
+     * @param x column of the center, in PIXELS
+     * @param y row of the center, in PIXELS
+     * @param radius outer radius, in PIXELS
+     * @param start_angle angle where the arc starts, in DEGREES
+     * @param end_angle angle where the arc ends, in DEGREES
+     * @param thickness width of the ring, in PIXELS, towards the center
+     * @param op operation applied to the pixels of the arc
+     * @return rows changed by the call, they are also marked for the next Flush()
+     */
+    LineRange DrawArc(int16_t x, int16_t y, uint16_t radius, uint16_t start_angle, uint16_t end_angle, uint8_t thickness = 1,
+                      PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws a filled sector of a circle (pie slice). The same as DrawArc() otherwise.
+     * 
+     */
+    LineRange FillArc(int16_t x, int16_t y, uint16_t radius, uint16_t start_angle, uint16_t end_angle, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws the outline of a rectangle with rounded corners.
+     * 
+     * @param x column of the left edge, in PIXELS
+     * @param y row of the top edge, in PIXELS
+     * @param width width, in PIXELS
+     * @param height height, in PIXELS
+     * @param radius radius of the corners, in PIXELS. It is limited to half of the shorter side.
+     * @param op operation applied to the pixels of the outline
+     * @return rows changed by the call, they are also marked for the next Flush()
+     */
+    LineRange DrawRoundRect(int16_t x, int16_t y, uint16_t width, uint16_t height, uint16_t radius, PixelOp op = PixelOp::kSet);
+
+    /**
+     * @brief Draws a filled rectangle with rounded corners as one span per row. The same as DrawRoundRect() otherwise.
+     * 
+     */
+    LineRange FillRoundRect(int16_t x, int16_t y, uint16_t width, uint16_t height, uint16_t radius, PixelOp op = PixelOp::kSet);
+
     /**
      * @brief Sends new pixel values to the screen. It updates all lines between line_start and line_end.
      * 
@@ -68,23 +372,529 @@ public:
     void RefreshScreen(uint8_t line_start, uint8_t line_end) override;
 
     /**
-     * @brief Clears the screen.
+     * @brief Sends to the screen only the rows which were changed by draw methods since the last refresh. 
+     * All dirty rows are sent in one transaction, even if they are not next to each other. If no row is dirty, nothing is sent.
+     * With double buffering it is the same as Present(), so every call swaps the buffers.
+     * 
+     */
+    void Flush();
+
+    /**
+     * @brief Enables or disables double buffering. Draw methods then change the back buffer, while refreshes send rows 
+     * of the front buffer, so drawing can continue during an asynchronous refresh without tearing. RefreshScreen() and RefreshLines()
+     * send the front buffer, i.e. the last presented frame. 
+     * Present() makes the back buffer visible. Costs one more screen buffer of RAM.
+     * 
+     * @param enable true to allocate the front buffer, false to release it.
+     */
+    void EnableDoubleBuffering(bool enable);
+
+    /**
+     * @brief Swaps back and front buffers and sends dirty rows of the new front buffer to the screen.
+     * Rows changed since the previous Present() are copied to the new back buffer, so drawing continues on the current content. 
+     * Waits for the transfer in progress, if any. Without double buffering it is the same as Flush().
+     * 
+     */
+    void Present();
+
+    /**
+     * @brief Sends new pixel values of all rows in the given ranges to the screen, in one transaction. 
+     * Ranges may be given in any order and may overlap, every row is sent once.
+     * 
+     * @param ranges array of ranges of rows to update.
+     * @param amount_of_ranges number of ranges in the array.
+     */
+    void RefreshLines(const LineRange ranges[], size_t amount_of_ranges);
+
+    /**
+     * @brief Sends new pixel values of all rows set in the bitmap to the screen, in one transaction.
+     * 
+     * @param rows bitmap of kRowBitmapWords_ words, bit (row % 32) of word (row / 32) is set if the row should be updated.
+     */
+    void RefreshLines(const uint32_t rows[]);
+
+    /**
+     * @brief Sets Chip Select timing of the panel. Every transaction waits exactly these times around Chip Select, 
+     * instead of a fixed delay. By default the timing of LS013B7DH05 is used, which is also safe for LS013B7DH03 and LS027B7DH01.
+     * 
+     * @param timing timing from the datasheet of the panel, e.g. kTiming_LS027B7DH01.
+     */
+    void SetTiming(const SharpMipTiming& timing);
+
+    /**
+     * @brief Enables or disables the shadow buffer, i.e. a copy of the pixels which were last sent to the screen.
+     * When enabled, refresh methods compare every requested row with the shadow buffer and skip the rows which did not change.
+     * If after the refresh the whole screen would be white, the short clear command is sent instead of the rows.
+     * When the content of the screen is known, ClearScreen() only clears the screen buffer and the clear is sent with the next refresh,
+     * so clearing and redrawing the same content sends nothing.
+     * The shadow buffer costs one more screen buffer of RAM. The content of the screen is known after the first ClearScreen(), 
+     * until then all requested rows are sent.
+     * 
+     * @param enable true to allocate the shadow buffer, false to release it.
+     */
+    void EnableShadowBuffer(bool enable);
+
+    /**
+     * @brief Enables cache of shifted glyphs for DrawLineOfTextAtPixel() with compressed fonts. Text which is drawn repeatedly at
+     * the same pixel offset, e.g. clock or counter, is then copied from the cache without decompressing and shifting. Raw fonts
+     * are shifted faster straight from the font and do not use the cache. The cache can be shared by more displays.
+     * 
+     * @param cache cache of shifted glyphs, owned by the caller. nullptr disables the cache.
+     */
+    void EnableGlyphCache(GlyphCache* cache);
+
+    /**
+     * @brief Enables asynchronous refresh. Refresh methods prepare the data, start the transfer with the given engine and return
+     * without waiting for the transfer. Chip Select is released from the completion interrupt. 
+     * Do not change the screen buffer in rows which are being sent until the transfer is completed.
+     * 
+     * @param dma engine used to send the data, e.g. Rp2040SpiDma. nullptr disables asynchronous refresh.
+     */
+    void EnableAsyncRefresh(SpiDma* dma);
+
+    /**
+     * @brief Sets the function which is called when an asynchronous refresh is completed. It is called from an interrupt.
+     * 
+     * @param callback function to call, nullptr to not call anything.
+     * @param context pointer passed to the callback.
+     */
+    void SetRefreshCallback(void (*callback)(void* context), void* context);
+
+    /**
+     * @brief Checks if an asynchronous refresh is in progress.
+     * 
+     * @return true if data is being sent to the screen.
+     */
+    bool IsBusy() const;
+
+    /**
+     * @brief Waits until the asynchronous refresh in progress is completed. Returns immediately if there is no transfer in progress.
+     * 
+     */
+    void WaitIdle() const;
+
+    /**
+     * @brief Starts a frame. Until the matching EndFrame(), ClearScreen() only clears the screen buffer, and RefreshScreen(), 
+     * RefreshLines(), Flush() and Present() send nothing. EndFrame() sends all of it in one transaction, 
+     * so the screen changes at once and never shows a cleared screen before the new content. Frames can be nested,
+     * only the outermost EndFrame() sends data.
+     * 
+     */
+    void BeginFrame();
+
+    /**
+     * @brief Ends a frame started by BeginFrame() and sends all rows cleared or refreshed during the frame in one transaction.
+     * If Flush() or Present() was called during the frame, it is done now, merged with the other rows.
+     * 
+     */
+    void EndFrame();
+
+    /**
+     * @brief Clears the screen. If the shadow buffer is enabled or a frame is started, the screen is cleared by the next refresh.
+     * With double buffering only the back buffer is cleared, the screen is cleared by the next Present().
      * 
      */
     void ClearScreen() override;
 
     /**
      * @brief Toggles the state of VCOM. Sharp MIP requires to toggle VCOM at least once per second. 
+     * Does nothing when VCOM is toggled by EnableExtcominPwm() or by EnableVcomTimer() with the pipeline. With EnableVcomTimer()
+     * without the pipeline it sends the VCOM command only if a timer tick requested it and no transaction has sent it since.
      * 
      */
     void ToggleVCOM();
 
+    /**
+     * @brief Drives EXTCOMIN pin of the display with a PWM slice, so VCOM is toggled by hardware without any CPU time.
+     * Requires EXTMODE pin of the display wired HIGH. 
+     * 
+     * @param extcomin_pin GPIO connected to EXTCOMIN.
+     * @param frequency_hz frequency of EXTCOMIN from the datasheet of the panel, e.g. 1-60 Hz. Frequencies below ~4 Hz are limited by PWM divider.
+     */
+    void EnableExtcominPwm(uint extcomin_pin, float frequency_hz);
+
+    /**
+     * @brief Toggles VCOM from a repeating timer, for displays with EXTMODE pin wired LOW. Transactions toggle VCOM anyway, 
+     * so a tick requests the 2 bytes long VCOM command only if there was no transaction since the previous tick.
+     * The timer interrupt does no SPI, it only sets a flag. The next transaction toggles VCOM and clears it. With EnablePipeline()
+     * core 1 sends the command. Without the pipeline call ToggleVCOM() from the main loop, more often than the period, so the
+     * command is sent when nothing else was sent.
+     * 
+     * @param period_ms period of the timer, shorter than 1 s.
+     */
+    void EnableVcomTimer(uint32_t period_ms = 500);
+
+    /**
+     * @brief Moves sending of data to core 1. Refresh methods, ClearScreen() and ToggleVCOM() only put a job in a queue and return,
+     * core 1 takes jobs from the queue and drives SPI, while core 0 draws the next frame. Rows are read from the screen buffer 
+     * when core 1 sends them, so do not draw in rows which are waiting to be sent, use WaitIdle() or IsBusy() to check it.
+     * Launches core 1, which then can not be used for anything else. The pipeline can not be disabled.
+     * 
+     */
+    void EnablePipeline();
+
+    /**
+     * @brief Stops EXTCOMIN PWM or VCOM timer. ToggleVCOM() has to be called again at least once per second.
+     * 
+     */
+    void DisableHardwareVcom();
+
+protected:
+
+    /**
+     * @brief Creates the display with buffers provided by a derived class, e.g. SharpMipDisplayT. The buffers live as long as
+     * the display and are not freed by it. nullptr means the buffer is allocated on the heap.
+     * 
+     * @param screen_buffer buffer of (width / 8 + 2 for BufferLayout::kWire) * height bytes.
+     * @param packet_buffer packet of asynchronous refreshes with BufferLayout::kPacked, (width / 8 + 2) * height + 2 bytes.
+     * Not used with BufferLayout::kWire.
+     * @param segments (height + 1) / 2 + 2 segments for BufferLayout::kWire, 1 for BufferLayout::kPacked.
+     */
+    SharpMipDisplay(uint16_t width, uint16_t height, spi_inst_t *spi, uint display_cs_pin, BufferLayout layout, uint8_t* screen_buffer,
+                    uint8_t* packet_buffer = nullptr, SpiDma::Segment* segments = nullptr);
+
+    /**
+     * @brief Marks rows as changed, so they are sent by the next Flush(). Inline, it is called for every pixel.
+     * 
+     * @param line_start first changed row, in PIXELS.
+     * @param line_end row after the last changed row, in PIXELS.
+     */
+    void MarkRowsDirty(uint16_t line_start, uint16_t line_end)
+    {
+        if(line_end > kScreenHeight_)
+        {
+            line_end = kScreenHeight_;
+        }
+        for (size_t i = line_start; i < line_end; i++)
+        {
+            dirty_rows_[i / 32] |= 1UL << (i % 32);
+            changed_rows_[i / 32] |= 1UL << (i % 32);
+        }
+    }
+
+    /**
+     * @brief Returns the buffer which is drawn to. It changes with every Present() if double buffering is enabled.
+     * 
+     */
+    uint8_t* ScreenBuffer() const
+    {
+        return screen_buffer_;
+    }
+
 private:
 
-    uint8_t SwapBigToLittleEndian(uint8_t big_endian);
-    void DrawLineOfTextReplace(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[]);
-    void DrawLineOfTextMix(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[]);
-    void DrawLineOfTextAdd(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[]);
+    /**
+     * @brief Reverses order of bits in a byte. Sharp expects line address LSB first, while SPI sends MSB first.
+     * 
+     * @param big_endian byte to reverse
+     * @return reversed byte, looked up in a table generated at compile time
+     */
+    static uint8_t SwapBigToLittleEndian(uint8_t big_endian);
+
+    /**
+     * @brief Sends all rows set in the given bitmap in one transaction and removes them from the dirty rows.
+     * 
+     * @param rows bitmap of rows, bit (row % 32) of word (row / 32) is set if the row should be sent.
+     */
+    void SendLines(const uint32_t rows[]);
+
+    /**
+     * @brief Removes from the bitmap the rows which are the same in the screen buffer and in the shadow buffer.
+     * 
+     * @param rows bitmap of rows, the same format as in SendLines().
+     * @return true if the screen would be fully white after sending the remaining rows.
+     */
+    bool DropUnchangedLines(uint32_t rows[]);
+    bool IsRowEqual(const uint8_t* row_a, const uint8_t* row_b) const;
+    bool IsRowWhite(const uint8_t* row) const;
+    void SendClearCommand();
+    void TransmitClear();
+    void TransmitVcom();
+    void TransmitLines(uint32_t rows_to_send[]);
+
+    /**
+     * @brief Sets Chip Select high, waiting for SCS low width and SCS setup time around it.
+     * 
+     */
+    void BeginTransaction();
+
+    /**
+     * @brief Sets Chip Select low after SCS hold time. Can be called from an interrupt.
+     * 
+     */
+    void EndTransaction();
+
+    /**
+     * @brief Waits until no transaction is in progress and marks the bus as used, atomically against the other core.
+     * Released by EndTransaction().
+     * 
+     */
+    void ClaimBus();
+    static bool OnVcomTimer(repeating_timer_t* timer);
+
+    /**
+     * @brief Job sent from core 0 to core 1 in pipeline mode.
+     * 
+     */
+    struct TransferJob
+    {
+        enum class Type : uint8_t{
+            kLines,
+            kClear,
+            kToggleVcom
+        };
+        Type type;
+        uint32_t rows[kRowBitmapWords_];
+    };
+    void PostTransferJob(TransferJob::Type type, const uint32_t rows[]);
+    static void Core1Entry();
+    void RunPipeline();
+    uint8_t LineWriteCommand();
+    void UpdateShadow(const uint32_t rows[]);
+    int BuildLinesPacket(const uint32_t rows[], uint8_t* buf);
+    size_t BuildWireSegments(const uint32_t rows[]);
+
+    /**
+     * @brief Sends the given rows of the packed layout with blocking writes in one transaction: the command, address, pixels and
+     * trailer of every row, then the final trailer. Nothing is copied.
+     * 
+     */
+    void StreamLines(const uint32_t rows[]);
+
+    /**
+     * @brief Sends the first amount_of_segments of transfer_segments_ in one transaction, asynchronously if DMA is enabled.
+     * 
+     */
+    void SendSegments(size_t amount_of_segments);
+
+    /**
+     * @brief Returns pointer to the first byte of pixels in the given row of the screen buffer.
+     * 
+     * @param y row, in PIXELS
+     */
+    uint8_t* RowPointer(uint16_t y) const
+    {
+        return &screen_buffer_[y * kRowStride_ + kRowOffset_];
+    }
+
+    /**
+     * @brief Returns pointer to the first byte of pixels in the given row of the buffer which is sent to the screen.
+     * It is the screen buffer, or the front buffer if double buffering is enabled.
+     * 
+     * @param y row, in PIXELS
+     */
+    const uint8_t* FrontRowPointer(uint16_t y) const
+    {
+        return &front_buffer_[y * kRowStride_ + kRowOffset_];
+    }
+    static void OnTransferComplete(void* context);
+
+    /**
+     * @brief Draws text with a font which is kWidthInBytes wide, using GlyphBlitter specialized for this width.
+     * 
+     */
+    template <uint8_t kWidthInBytes>
+    void DrawLineOfTextFixed(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode);
+
+    /**
+     * @brief Draws text with a proportional font at any pixel column. Glyphs are placed using their advances and kerning pairs.
+     * 
+     */
+    void DrawLineOfTextProportional(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode);
+
+    /**
+     * @brief Applies the operation to pixels from x_start to x_end (excluded) in amount_of_rows rows starting at y. 
+     * The span has to be on the screen. Does not mark rows as dirty.
+     * 
+     */
+    void ApplySpan(uint16_t x_start, uint16_t x_end, uint16_t y, uint16_t amount_of_rows, PixelOp op);
+
+    /**
+     * @brief Clips the rectangle to the screen, applies the operation to it and marks its rows as dirty.
+     * 
+     */
+    LineRange ApplyRect(uint16_t x, uint16_t y, uint16_t width, uint16_t height, PixelOp op);
+
+    // Number of different bytes whose masks DrawVerticalSegments() merges before it walks the rows
+    static constexpr size_t kMaxSegmentBytes_{16};
+
+    /**
+     * @brief Applies masks to bytes of rows from y_first to y_last, both on the screen, and marks them dirty.
+     * 
+     */
+    void ApplyColumnMasks(const uint8_t byte_indexes[], const uint8_t masks[], size_t amount_of_bytes, uint16_t y_first, uint16_t y_last,
+                          PixelOp op);
+
+    /**
+     * @brief Draws rows from y_start to y_end (excluded) of the bitmap placed at (x, y), between columns x_start and x_end (excluded).
+     * If mask_bitmap is not nullptr, only pixels with 1 in the mask are drawn. The mask has the size and the stride of the bitmap.
+     * The area has to be on the screen. Does not mark rows as dirty.
+     * 
+     */
+    template <RasterOp kOp>
+    void BlitBitmapRows(int16_t x, int16_t y, const uint8_t bitmap[], const uint8_t mask_bitmap[], uint16_t width, uint16_t stride,
+                        int32_t x_start, int32_t x_end, int32_t y_start, int32_t y_end);
+
+    /**
+     * @brief Returns 32 pixels of a bitmap row starting at pixel 8 * byte + shift. The byte may be outside of the row,
+     * bytes before and after the row are not read and their pixels have to be masked by the caller.
+     * 
+     */
+    static uint32_t LoadBitmapWord(const uint8_t* row, int32_t byte, int32_t width_in_bytes, uint8_t shift);
+
+    /**
+     * @brief Clips the span from x_first to x_last (both included, in any order) in row y to the screen and applies the operation to it.
+     * Rows are not marked as dirty, but dirty is extended by the row if any pixel was changed.
+     * 
+     * @return true if any pixel was changed
+     */
+    bool ApplyClippedSpan(int32_t x_first, int32_t x_last, int32_t y, PixelOp op, LineRange& dirty);
+
+    /**
+     * @brief Draws a shape which has one span in every row from y_first to y_last. row_edges(y, left, right) returns false for an empty
+     * row, otherwise it sets the first and last pixel of the row. An outline keeps the pixels which have a neighbour outside of the shape.
+     * 
+     */
+    template <typename RowEdges>
+    LineRange DrawRowSpans(int32_t y_first, int32_t y_last, bool filled, PixelOp op, RowEdges row_edges);
+
+    /**
+     * @brief Draws a line which is at least 2 pixels thick, as a filled rectangle around it.
+     * 
+     */
+    LineRange DrawThickLine(int16_t x0, int16_t y0, int16_t x1, int16_t y1, uint8_t thickness, PixelOp op);
+
+    /**
+     * @brief Draws the part of a ring between angles. Pixels closer to the center than inner_radius are not changed,
+     * negative inner_radius fills the whole sector.
+     * 
+     */
+    LineRange DrawRing(int16_t x, int16_t y, uint16_t radius, int32_t inner_radius, uint16_t start_angle, uint16_t end_angle, PixelOp op);
+
+    /**
+     * @brief Draws text with a compressed font which is kWidthInBytes wide. Glyph rows are decoded directly into the screen buffer.
+     * 
+     */
+    template <uint8_t kWidthInBytes>
+    void DrawLineOfTextCompressed(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode);
+
+    /**
+     * @brief Draws text with a font which is kWidthInBytes wide at any pixel column. Text with a raw font is shifted
+     * straight from the font into the screen buffer, several rows of a glyph at once.
+     * 
+     */
+    template <uint8_t kWidthInBytes>
+    void DrawLineOfTextShifted(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode);
+
+    // Characters which DrawLineOfTextShifted() draws at once, it keeps a pointer to each of their glyphs on the stack
+    static constexpr uint8_t kShiftedRunLength_{32};
+
+    // Register of the CPU, 32 bits on RP2040, 64 bits on most hosts. Shifted text is merged one TextWord at a time.
+    using TextWord = uintptr_t;
+
+    /**
+     * @brief Shifts rows of the glyphs right by shift pixels, 1 to 7, into amount_of_chars * kWidthInBytes + 1 bytes of every row.
+     * Pixels left of the text in the first byte are kept, the rest of the last byte depends on the mode.
+     * 
+     */
+    template <uint8_t kWidthInBytes>
+    void MergeShiftedRun(uint8_t* destination, const uint8_t* const glyphs[], uint8_t amount_of_chars, uint8_t rows_to_draw,
+                         uint8_t shift, Mode mode);
+
+    template <uint8_t kWidthInBytes, Mode kMode>
+    void MergeShiftedRun(uint8_t* destination, const uint8_t* const glyphs[], uint8_t amount_of_chars, uint8_t rows_to_draw,
+                         uint8_t shift);
+
+    /**
+     * @brief Shifts kWords * kRows rows of the glyphs from glyph_offset, kRows rows of a glyph in each of kWords TextWords,
+     * like MergeShiftedRun().
+     * 
+     */
+    template <uint8_t kWidthInBytes, uint8_t kRows, uint8_t kWords, Mode kMode>
+    static void MergeShiftedRows(uint8_t* destination, size_t row_stride, const uint8_t* const glyphs[], uint8_t amount_of_chars,
+                                 size_t glyph_offset, uint8_t shift);
+
+    /**
+     * @brief Reads kRows rows of a glyph into a TextWord, first byte in the most significant bits like LoadBigEndian().
+     * Rows 3 bytes wide are read with the bytes before them, a glyph is preceded by at least the 3 bytes of the font header.
+     * 
+     */
+    template <uint8_t kWidthInBytes, uint8_t kRows>
+    static TextWord LoadGlyphRows(const uint8_t* rows)
+    {
+        constexpr uint8_t kBytes = kRows * kWidthInBytes;
+        constexpr uint8_t kLoadedBytes = (kBytes == 3) ? 4 : ((kBytes == 6) ? 8 : kBytes);
+        TextWord word{0};
+        std::memcpy(&word, rows + kBytes - kLoadedBytes, kLoadedBytes);
+        word = (sizeof(word) == 8) ? __builtin_bswap64(word) : __builtin_bswap32(word);
+        return word << (8 * (kLoadedBytes - kBytes));
+    }
+
+    /**
+     * @brief Draws shifted text with a compressed font glyph by glyph, from the GlyphCache if it is enabled.
+     * 
+     */
+    template <uint8_t kWidthInBytes>
+    void DrawLineOfTextShiftedByGlyph(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode);
+
+    /**
+     * @brief Stores one glyph of DrawLineOfTextShifted() into kWidthInBytes bytes of consecutive rows. next_row returns the glyph row
+     * shifted right and the pixels shifted out of it, carry holds the pixels shifted out of the previous glyph in every row.
+     * 
+     */
+    template <uint8_t kWidthInBytes, typename NextRow>
+    void MergeShiftedGlyph(uint8_t* destination, uint8_t rows_to_draw, uint8_t carry[], Mode mode, NextRow next_row);
+
+    /**
+     * @brief Reads kBytes bytes as a 32-bit word, first byte in the most significant bits. Leftmost pixel is the MSB, 
+     * so shifting the word right moves pixels right.
+     * 
+     */
+    template <uint8_t kBytes>
+    static uint32_t LoadBigEndian(const uint8_t* bytes)
+    {
+        // Copies of 3 bytes go through the stack, they are split into 2 bytes and 1 byte
+        if(kBytes == 3)
+        {
+            return LoadBigEndian<2>(bytes) | (static_cast<uint32_t>(bytes[2]) << 8);
+        }
+        // RP2040 is little endian, the first byte lands in the least significant bits and the swap moves it to the top
+        uint32_t word{0};
+        std::memcpy(&word, bytes, kBytes);
+        return __builtin_bswap32(word);
+    }
+
+    /**
+     * @brief Writes kBytes most significant bytes of the word, the reverse of LoadBigEndian().
+     * 
+     */
+    template <uint8_t kBytes>
+    static void StoreBigEndian(uint8_t* bytes, uint32_t word)
+    {
+        if(kBytes == 3)
+        {
+            StoreBigEndian<2>(bytes, word);
+            bytes[2] = static_cast<uint8_t>(word >> 8);
+            return;
+        }
+        word = __builtin_bswap32(word);
+        std::memcpy(bytes, &word, kBytes);
+    }
+
+    /**
+     * @brief Draws text with a font of any width, byte by byte.
+     * 
+     */
+    void DrawLineOfTextGeneric(uint16_t x, uint16_t y, const std::string& new_string, const uint8_t font[], Mode mode);
+
+    /**
+     * @brief Makes white all pixels from column x to the end of rows. Used by Mode::kReplace.
+     * 
+     * @param x column, in BYTES
+     * @param y first row, in PIXELS
+     * @param amount_of_rows number of rows to erase
+     */
+    void EraseRestOfRows(uint16_t x, uint16_t y, uint8_t amount_of_rows);
 
     /**
      * @brief Helper function to print array of pixels in the terminal. Used only during debugging.
@@ -99,8 +909,60 @@ private:
     const uint kDisplaySpiCsPin_;
     spi_inst_t *kSPI_;
     bool vcom_bool_{false};
+    enum class VcomMode{
+        kSoftware,
+        kExtcominPwm,
+        kTimer
+    };
+    VcomMode vcom_mode_{VcomMode::kSoftware};
+    uint extcomin_pin_{0};
+    repeating_timer_t vcom_timer_{};
+    // Set by transactions on either core, cleared by the VCOM timer interrupt
+    std::atomic<bool> vcom_toggled_{false};
+    // Set by the VCOM timer interrupt, cleared by the next transaction. Core 1 or ToggleVCOM() send the VCOM command for it
+    std::atomic<bool> vcom_requested_{false};
+    spin_lock_t* bus_lock_{spin_lock_init(spin_lock_claim_unused(true))};
+    SharpMipTiming timing_{kTiming_LS013B7DH05};
+    uint32_t cs_low_time_us_{0};
     const uint8_t kScreenWidthInWords_ = kScreenWidth_ / 8;
-    uint8_t* screen_buffer_ = new uint8_t[kScreenWidthInWords_ * kScreenHeight_]{};
+    const BufferLayout kLayout_;
+    // Distance between rows in screen buffer and position of the first pixel byte in a row, in BYTES
+    const uint8_t kRowStride_ = (kLayout_ == BufferLayout::kWire) ? kScreenWidthInWords_ + 2 : kScreenWidthInWords_;
+    const uint8_t kRowOffset_ = (kLayout_ == BufferLayout::kWire) ? 1 : 0;
+    uint8_t* screen_buffer_;
+    // Buffer passed to or allocated by the constructor, screen_buffer_ and front_buffer_ swap it with the second one
+    uint8_t* const kPrimaryBuffer_;
+    const bool kOwnsPrimaryBuffer_;
+    uint32_t dirty_rows_[kRowBitmapWords_]{};
+    uint8_t* front_buffer_{screen_buffer_};
+    // Rows of the back buffer changed since the last Present(), they are not cleared by refreshes
+    uint32_t changed_rows_[kRowBitmapWords_]{};
+    uint8_t* shadow_buffer_{nullptr};
+    // Set by the transfer side, which runs on core 1 with the pipeline, and read by ClearScreen() on core 0
+    std::atomic<bool> shadow_valid_{false};
+    // Rows which have to be sent with the next refresh, even if they are not in its range
+    uint32_t pending_rows_[kRowBitmapWords_]{};
+    uint8_t frame_depth_{0};
+    bool frame_present_{false};
+    GlyphCache* glyph_cache_{nullptr};
+    SpiDma* dma_{nullptr};
+    // Packed layout builds the line packet for DMA here: command, all lines with address and trailer, final trailer.
+    // Set only while asynchronous refresh is enabled, blocking refreshes send the rows straight from the screen buffer.
+    // Points to kPacketStorage_, or to the heap if there is none.
+    uint8_t* transfer_buffer_{nullptr};
+    uint8_t* const kPacketStorage_;
+    // Packed layout sends 1 segment, wire layout sends the command, up to every second row and the final trailer
+    SpiDma::Segment* const transfer_segments_;
+    const bool kOwnsTransferSegments_;
+    uint8_t wire_command_{0};
+    static constexpr uint8_t kTransmissionTrailer_{0};
+    // Cleared by the completion interrupt or core 1, so the buffers of the transfer are released to the other side
+    std::atomic<bool> transfer_in_progress_{false};
+    static constexpr size_t kPipelineDepth_{4};
+    SpscQueue<TransferJob, kPipelineDepth_>* pipeline_queue_{nullptr};
+    std::atomic<bool> pipeline_active_{false};
+    void (*refresh_callback_)(void* context){nullptr};
+    void* refresh_callback_context_{nullptr};
 };
 
 
@@ -0,0 +1,137 @@
+#ifndef SHARP_MIP_DISPLAY_T_H
+#define SHARP_MIP_DISPLAY_T_H
+
+
+#include "sharp_mip_display.h"
+#include "../static_display.h"
+
+/**
+ * @brief Screen buffer, packet buffer and transfer segments of SharpMipDisplayT. It is a base class, so it is constructed before
+ * SharpMipDisplay, which initializes it.
+ *
+ * @tparam kSize size of the screen buffer in BYTES.
+ * @tparam kPacketSize size of the packet of asynchronous refreshes in BYTES.
+ * @tparam kSegments amount of transfer segments.
+ */
+template <size_t kSize, size_t kPacketSize, size_t kSegments>
+struct SharpMipScreenBuffer
+{
+    alignas(4) uint8_t screen_buffer_storage_[kSize];
+    uint8_t packet_storage_[kPacketSize];
+    SpiDma::Segment segment_storage_[kSegments];
+};
+
+/**
+ * @brief SharpMipDisplay with dimensions known at compile time. The screen buffer, the packet of asynchronous refreshes and the
+ * transfer segments are members of the object, so a global display is placed in .bss instead of the heap. Declare it as a global
+ * or static object, the buffers are too big for the stack. Double buffering, the shadow buffer and the pipeline still allocate
+ * on the heap when they are enabled.
+ * Only SetPixel(), ResetPixel(), DrawHorizontalLine() and DrawVerticalLine() use constant strides and bounds, and are inlined when
+ * they are called on SharpMipDisplayT or through StaticDisplay, not through Display. Text, rectangles, shapes and refreshes are
+ * the methods of SharpMipDisplay, with the stride read at run time.
+ *
+ * @tparam kWidth width of the screen in PIXELS, multiple of 8.
+ * @tparam kHeight height of the screen in PIXELS, at most 256.
+ * @tparam kLayout layout of the screen buffer, see SharpMipDisplay::BufferLayout.
+ */
+template <uint16_t kWidth, uint16_t kHeight, SharpMipDisplay::BufferLayout kLayout = SharpMipDisplay::BufferLayout::kPacked>
+class SharpMipDisplayT : private SharpMipScreenBuffer<(kWidth / 8 + (kLayout == SharpMipDisplay::BufferLayout::kWire ? 2 : 0)) * kHeight,
+                                                      // Wire layout sends the rows from the screen buffer, it needs no packet
+                                                      (kLayout == SharpMipDisplay::BufferLayout::kWire) ? 1 : 1 + kHeight * (kWidth / 8 + 2) + 1,
+                                                      (kLayout == SharpMipDisplay::BufferLayout::kWire) ? (kHeight + 1) / 2 + 2 : 1>,
+                         public SharpMipDisplay,
+                         public StaticDisplay<SharpMipDisplayT<kWidth, kHeight, kLayout>>
+{
+public:
+
+    static constexpr uint16_t kWidthInBytes = kWidth / 8;
+    // Distance between rows in screen buffer and position of the first pixel byte in a row, in BYTES
+    static constexpr uint16_t kRowStride = (kLayout == BufferLayout::kWire) ? kWidthInBytes + 2 : kWidthInBytes;
+    static constexpr uint16_t kRowOffset = (kLayout == BufferLayout::kWire) ? 1 : 0;
+
+    static_assert(kWidth % 8 == 0, "Width of the screen has to be a multiple of 8");
+    static_assert(kHeight <= kRowBitmapWords_ * 32, "Lines are addressed with 8 bits, height has to be at most 256");
+    static_assert(kRowStride <= 255, "Row of the screen buffer has to fit into 255 bytes");
+
+    /**
+     * @param spi SPI instance, initialized by the caller.
+     * @param display_cs_pin Chip Select pin of the display.
+     */
+    SharpMipDisplayT(spi_inst_t *spi, uint display_cs_pin)
+    : SharpMipDisplay(kWidth, kHeight, spi, display_cs_pin, kLayout, this->screen_buffer_storage_, this->packet_storage_, this->segment_storage_)
+    {
+    }
+
+    static constexpr uint16_t Width()
+    {
+        return kWidth;
+    }
+
+    static constexpr uint16_t Height()
+    {
+        return kHeight;
+    }
+
+    void SetPixel(uint16_t x, uint16_t y) final
+    {
+        if(x >= kWidth || y >= kHeight)
+        {
+            return;
+        }
+        RowPointer(y)[x / 8] &= ~(0b10000000 >> (x % 8));
+        MarkRowsDirty(y, y + 1);
+    }
+
+    void ResetPixel(uint16_t x, uint16_t y) final
+    {
+        if(x >= kWidth || y >= kHeight)
+        {
+            return;
+        }
+        RowPointer(y)[x / 8] |= 0b10000000 >> (x % 8);
+        MarkRowsDirty(y, y + 1);
+    }
+
+    void DrawHorizontalLine(uint16_t x) final
+    {
+        if(x >= kHeight)
+        {
+            return;
+        }
+        std::fill(RowPointer(x), RowPointer(x) + kWidthInBytes, 0b00000000);
+        MarkRowsDirty(x, x + 1);
+    }
+
+    void DrawVerticalLine(uint16_t y) final
+    {
+        if(y >= kWidth)
+        {
+            return;
+        }
+        const uint8_t mask = ~(0b10000000 >> (y % 8));
+        uint8_t* pixels = RowPointer(0) + y / 8;
+        for(uint16_t i = 0; i < kHeight; ++i)
+        {
+            *pixels &= mask;
+            pixels += kRowStride;
+        }
+        MarkRowsDirty(0, kHeight);
+    }
+
+private:
+
+    uint8_t* RowPointer(uint16_t y) const
+    {
+        return ScreenBuffer() + y * kRowStride + kRowOffset;
+    }
+};
+
+// 1.26" LS013B7DH05
+using SharpMipDisplay144x168 = SharpMipDisplayT<144, 168>;
+// 1.28" LS013B7DH03, call SetTiming(kTiming_LS013B7DH03)
+using SharpMipDisplay128x128 = SharpMipDisplayT<128, 128>;
+// 2.7" LS027B7DH01, call SetTiming(kTiming_LS027B7DH01)
+using SharpMipDisplay400x240 = SharpMipDisplayT<400, 240>;
+
+
+#endif // SHARP_MIP_DISPLAY_T_H
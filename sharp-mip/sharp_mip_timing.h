@@ -0,0 +1,26 @@
+#ifndef SHARP_MIP_TIMING_H
+#define SHARP_MIP_TIMING_H
+
+
+#include <stdint.h>
+
+/**
+ * @brief Chip Select timing of a Sharp Memory display, in MICROSECONDS. Values are minimums from the datasheet of the panel.
+ *
+ */
+struct SharpMipTiming
+{
+    uint16_t tsSCS;     // SCS setup time: from SCS high to the first SCLK
+    uint16_t thSCS;     // SCS hold time: from the last SCLK to SCS low
+    uint16_t twSCSL;    // SCS low width: from SCS low to the next SCS high
+};
+
+// 1.28" 128x128
+constexpr SharpMipTiming kTiming_LS013B7DH03{6, 2, 6};
+// 1.26" 144x168
+constexpr SharpMipTiming kTiming_LS013B7DH05{6, 2, 6};
+// 2.7" 400x240
+constexpr SharpMipTiming kTiming_LS027B7DH01{3, 1, 1};
+
+
+#endif // SHARP_MIP_TIMING_H
@@ -0,0 +1,72 @@
+#ifndef SPI_DMA_H
+#define SPI_DMA_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * @brief Engine which sends a buffer over SPI in the background. SharpMipDisplay uses it for asynchronous refresh.
+ * The hardware implementation for RP2040 is Rp2040SpiDma, other implementations (e.g. a mock on the host) only need to
+ * call TransferComplete() when the last byte left the SPI.
+ */
+class SpiDma
+{
+public:
+    using CompletionHandler = void (*)(void* context);
+
+    /**
+     * @brief Continuous block of memory which is a part of one transfer.
+     *
+     */
+    struct Segment
+    {
+        const uint8_t* data;
+        size_t length;
+    };
+
+    virtual ~SpiDma() = default;
+
+    /**
+     * @brief Starts sending the segments one after another, as one transfer, and returns immediately. 
+     * The segments and their data have to stay valid until the transfer is completed.
+     *
+     * @param segments array of segments to send.
+     * @param amount_of_segments number of segments in the array, at least 1.
+     */
+    virtual void StartTransfer(const Segment segments[], size_t amount_of_segments) = 0;
+
+    /**
+     * @brief Sets the function which is called when a transfer is completed. It may be called from an interrupt.
+     *
+     * @param handler function to call, nullptr to not call anything.
+     * @param context pointer passed to the handler.
+     */
+    void SetCompletionHandler(CompletionHandler handler, void* context)
+    {
+        completion_handler_ = handler;
+        completion_context_ = context;
+    }
+
+protected:
+
+    /**
+     * @brief Has to be called by the implementation when all bytes of the transfer left the SPI.
+     *
+     */
+    void TransferComplete()
+    {
+        if(completion_handler_ != nullptr)
+        {
+            completion_handler_(completion_context_);
+        }
+    }
+
+private:
+
+    CompletionHandler completion_handler_{nullptr};
+    void* completion_context_{nullptr};
+};
+
+
+#endif // SPI_DMA_H
@@ -0,0 +1,12 @@
+#include "sprite.h"
+
+Sprite::Sprite(const uint8_t image[], const uint8_t mask[], uint16_t width, uint16_t height, uint16_t stride)
+: kImage_{image}, kMask_{mask}, kWidth_{width}, kHeight_{height}, kStride_{stride},
+  background_{new uint8_t[static_cast<size_t>((width + 7) / 8 + 1) * height]}
+{
+}
+
+Sprite::~Sprite()
+{
+    delete[] background_;
+}
@@ -0,0 +1,80 @@
+#ifndef SPRITE_H
+#define SPRITE_H
+
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * @brief Small image which is moved over static content, e.g. a cursor or a marker, drawn by SharpMipDisplay::DrawSprite().
+ * The sprite keeps a copy of the screen bytes it covers, so moving or hiding it restores the background without redrawing it.
+ *
+ * Image and mask have 1 bit per pixel, the same size and the same stride. Pixels of the image are in the format of the screen
+ * buffer, 1 is white and 0 is black. Pixels with 1 in the mask are drawn, pixels with 0 are transparent.
+ * Both tables are not copied, they have to live as long as the sprite.
+ *
+ * The background is saved in whole bytes. Content drawn under a visible sprite is overwritten by the saved background when
+ * the sprite moves, so hide the sprite before the area below it is redrawn, and hide overlapping sprites in the reverse order
+ * in which they were drawn.
+ *
+ */
+class Sprite
+{
+public:
+
+    /**
+     * @brief Allocates the buffer for the background, ((width + 7) / 8 + 1) * height bytes.
+     *
+     * @param image rows of the image, stride bytes apart.
+     * @param mask rows of the mask, stride bytes apart.
+     * @param width width of the sprite in PIXELS.
+     * @param height height of the sprite in PIXELS.
+     * @param stride distance between rows of the image and of the mask, in BYTES, at least (width + 7) / 8.
+     */
+    Sprite(const uint8_t image[], const uint8_t mask[], uint16_t width, uint16_t height, uint16_t stride);
+    ~Sprite();
+
+    Sprite(const Sprite&) = delete;
+    Sprite& operator=(const Sprite&) = delete;
+
+    /**
+     * @brief True between DrawSprite() and HideSprite().
+     *
+     */
+    bool IsVisible() const { return visible_; }
+
+    /**
+     * @brief Column of the left edge, in PIXELS, from the last DrawSprite().
+     *
+     */
+    int16_t GetX() const { return x_; }
+
+    /**
+     * @brief Row of the top edge, in PIXELS, from the last DrawSprite().
+     *
+     */
+    int16_t GetY() const { return y_; }
+
+private:
+
+    // The display draws the sprite and keeps its background
+    friend class SharpMipDisplay;
+
+    const uint8_t* const kImage_;
+    const uint8_t* const kMask_;
+    const uint16_t kWidth_;
+    const uint16_t kHeight_;
+    const uint16_t kStride_;
+    uint8_t* background_;           // saved_bytes_per_row_ bytes for each of saved_rows_ rows
+    bool visible_{false};
+    int16_t x_{0};
+    int16_t y_{0};
+    // Part of the screen buffer saved in background_, only the visible part of the sprite
+    uint16_t saved_first_byte_{0};
+    uint16_t saved_bytes_per_row_{0};
+    uint16_t saved_first_row_{0};
+    uint16_t saved_rows_{0};
+};
+
+
+#endif // SPRITE_H
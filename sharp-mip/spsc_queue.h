@@ -0,0 +1,74 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+
+#include <stdlib.h>
+#include <atomic>
+
+/**
+ * @brief Lock-free queue for exactly one producer and one consumer, e.g. core 0 and core 1 of RP2040.
+ * It uses only atomic loads and stores, which Cortex-M0+ supports, and compiles on a PC as well.
+ *
+ * @tparam T type of items, copied in and out of the queue.
+ * @tparam kCapacity maximal number of items in the queue, power of 2.
+ */
+template <typename T, size_t kCapacity>
+class SpscQueue
+{
+    static_assert(kCapacity > 0 && (kCapacity & (kCapacity - 1)) == 0, "Capacity of SpscQueue has to be a power of 2");
+
+public:
+
+    /**
+     * @brief Adds item at the end of the queue. Called only by the producer.
+     *
+     * @return false if the queue is full.
+     */
+    bool TryPush(const T& item)
+    {
+        const size_t tail = tail_.load(std::memory_order_relaxed);
+        if(tail - head_.load(std::memory_order_acquire) == kCapacity)
+        {
+            return false;
+        }
+        items_[tail % kCapacity] = item;
+        tail_.store(tail + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Takes item from the front of the queue. Called only by the consumer.
+     *
+     * @return false if the queue is empty.
+     */
+    bool TryPop(T& item)
+    {
+        const size_t head = head_.load(std::memory_order_relaxed);
+        if(head == tail_.load(std::memory_order_acquire))
+        {
+            return false;
+        }
+        item = items_[head % kCapacity];
+        head_.store(head + 1, std::memory_order_release);
+        return true;
+    }
+
+    /**
+     * @brief Checks if the queue is empty. Can be called by both sides.
+     *
+     */
+    bool IsEmpty() const
+    {
+        return head_.load(std::memory_order_acquire) == tail_.load(std::memory_order_acquire);
+    }
+
+private:
+
+    T items_[kCapacity];
+    // Counters only grow, index of an item is counter % kCapacity
+    std::atomic<size_t> head_{0};   // written only by the consumer
+    std::atomic<size_t> tail_{0};   // written only by the producer
+};
+
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,85 @@
+#ifndef STATIC_DISPLAY_H
+#define STATIC_DISPLAY_H
+
+#include <stdlib.h>
+#include <stdint.h>
+
+/**
+ * @brief Statically dispatched counterpart of Display (CRTP). Drawing code written as a template over StaticDisplay<Derived> calls
+ * the primitives of Derived directly, so they can be inlined and the loops around them optimized, without a virtual call per pixel.
+ * Display stays the type-erased interface for code which selects the display at runtime.
+ *
+ * Derived has to define SetPixel(), ResetPixel(), DrawHorizontalLine() and DrawVerticalLine() with the same meaning as in Display,
+ * and static constexpr Width() and Height(), e.g. SharpMipDisplayT.
+ *
+ * @tparam Derived display class which derives from StaticDisplay<Derived>.
+ */
+template <typename Derived>
+class StaticDisplay
+{
+public:
+
+    static constexpr uint16_t Width()
+    {
+        return Derived::Width();
+    }
+
+    static constexpr uint16_t Height()
+    {
+        return Derived::Height();
+    }
+
+    void SetPixel(uint16_t x, uint16_t y)
+    {
+        Self().SetPixel(x, y);
+    }
+
+    void ResetPixel(uint16_t x, uint16_t y)
+    {
+        Self().ResetPixel(x, y);
+    }
+
+    /**
+     * @brief Sets the pixel to black or white.
+     *
+     * @param x column, in PIXELS.
+     * @param y row, in PIXELS.
+     * @param black true for black pixel, false for white.
+     */
+    void DrawPixel(uint16_t x, uint16_t y, bool black)
+    {
+        if(black)
+        {
+            Self().SetPixel(x, y);
+        }
+        else
+        {
+            Self().ResetPixel(x, y);
+        }
+    }
+
+    void DrawHorizontalLine(uint16_t x)
+    {
+        Self().DrawHorizontalLine(x);
+    }
+
+    void DrawVerticalLine(uint16_t y)
+    {
+        Self().DrawVerticalLine(y);
+    }
+
+protected:
+
+    // Only derived classes are displays, StaticDisplay alone is never created
+    StaticDisplay() = default;
+    ~StaticDisplay() = default;
+
+private:
+
+    Derived& Self()
+    {
+        return static_cast<Derived&>(*this);
+    }
+};
+
+#endif // STATIC_DISPLAY_H
@@ -0,0 +1,38 @@
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <chrono>
+#include <cstdio>
+
+/**
+ * @brief Runs the function repeatedly and returns the best time of one call in NANOSECONDS, divided by work_per_call,
+ * e.g. by the number of pixels drawn in one call.
+ *
+ */
+template <typename Function>
+double MeasureNs(Function function, double work_per_call = 1.0, int calls = 200, int rounds = 5)
+{
+    double best{1e300};
+    for (int round = 0; round < rounds; ++round)
+    {
+        const auto start = std::chrono::steady_clock::now();
+        for (int i = 0; i < calls; ++i)
+        {
+            function();
+        }
+        const std::chrono::duration<double, std::nano> elapsed = std::chrono::steady_clock::now() - start;
+        const double ns = elapsed.count() / calls / work_per_call;
+        best = (ns < best) ? ns : best;
+    }
+    return best;
+}
+
+// Keeps the compiler from removing a computation whose result is not used
+template <typename T>
+inline void DoNotOptimize(const T& value)
+{
+    asm volatile("" : : "r,m"(value) : "memory");
+}
+
+
+#endif // BENCH_H
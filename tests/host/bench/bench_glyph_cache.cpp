@@ -0,0 +1,61 @@
+// Clock text drawn by DrawLineOfTextAtPixel() with every glyph found in GlyphCache against the same text drawn without the cache.
+// Raw fonts do not use the cache, so for them both times are of the same path.
+
+#include <algorithm>
+#include <string>
+#include "sharp_mip_display.h"
+#include "glyph_cache.h"
+#include "fonts/font_8x10_compressed.h"
+#include "fonts/font_16x20_compressed.h"
+#include "fonts/font_24x30_compressed.h"
+#include "fonts/font_32x40_compressed.h"
+#include "bench.h"
+
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+
+struct Font
+{
+    const char* name;
+    const uint8_t* table;
+};
+
+int main()
+{
+    const Font fonts[]{
+        {"8x10", kFont_8_10},
+        {"16x20", kFont_16_20},
+        {"24x30", kFont_24_30},
+        {"32x40", kFont_32_40},
+        {"8x10c", kFont_8_10_Compressed.data()},
+        {"16x20c", kFont_16_20_Compressed.data()},
+        {"24x30c", kFont_24_30_Compressed.data()},
+        {"32x40c", kFont_32_40_Compressed.data()},
+    };
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17);
+    // Big enough for every glyph of the text, so after the first call all of them are hits
+    GlyphCache cache(16, 5 * 40);
+
+    for (const Font& font : fonts)
+    {
+        const uint8_t glyph_width_in_bytes{FontWidthInBytes(font.table)};
+        const uint8_t glyph_height{font.table[1]};
+        const std::string text{"12:00"};
+        const double pixels = text.size() * glyph_width_in_bytes * 8.0 * glyph_height;
+
+        double uncached_ns{1e300};
+        double hit_ns{1e300};
+        for (int round = 0; round < 40; ++round)
+        {
+            display.EnableGlyphCache(nullptr);
+            uncached_ns = std::min(uncached_ns, MeasureNs([&]() { display.DrawLineOfTextAtPixel(11, 20, text, font.table, Display::Mode::kMix); }, pixels, 50, 1));
+            display.EnableGlyphCache(&cache);
+            display.DrawLineOfTextAtPixel(11, 20, text, font.table, Display::Mode::kMix);
+            cache.ResetCounters();
+            hit_ns = std::min(hit_ns, MeasureNs([&]() { display.DrawLineOfTextAtPixel(11, 20, text, font.table, Display::Mode::kMix); }, pixels, 50, 1));
+        }
+        std::printf("%-6s uncached %6.3f ns per pixel, cache hits %6.3f ns per pixel (%u misses), ratio %.2f\n",
+                    font.name, uncached_ns, hit_ns, static_cast<unsigned>(cache.GetMisses()), hit_ns / uncached_ns);
+    }
+    return 0;
+}
@@ -0,0 +1,82 @@
+// Line address reversal: std::bitset and std::string, as before, against the lookup table of SharpMipDisplay
+
+#include <algorithm>
+#include <array>
+#include <bitset>
+#include <string>
+#include "sharp_mip_display.h"
+#include "host_stub.h"
+#include "bench.h"
+
+static uint8_t SwapWithBitset(uint8_t big_endian)
+{
+    std::string string_be = std::bitset<8>(big_endian).to_string();
+    std::reverse(string_be.begin(), string_be.end());
+    std::bitset<8> bitset_le(string_be);
+    return static_cast<uint8_t>(bitset_le.to_ulong());
+}
+
+// The same table as in sharp_mip_display.cpp, where it is private
+static constexpr std::array<uint8_t, 256> MakeBitReversalTable()
+{
+    std::array<uint8_t, 256> table{};
+    for (size_t i = 0; i < 256; ++i)
+    {
+        for (size_t bit = 0; bit < 8; ++bit)
+        {
+            table[i] |= ((i >> bit) & 1) << (7 - bit);
+        }
+    }
+    return table;
+}
+
+static constexpr std::array<uint8_t, 256> kBitReversalTable = MakeBitReversalTable();
+
+static uint8_t SwapWithTable(uint8_t big_endian)
+{
+    return kBitReversalTable[big_endian];
+}
+
+int main()
+{
+    constexpr int kRows{168};
+    for (int i = 0; i < 256; ++i)
+    {
+        if(SwapWithBitset(i) != SwapWithTable(i))
+        {
+            std::printf("tables differ at %d\n", i);
+            return 1;
+        }
+    }
+
+    // Addresses of all rows of a full refresh of LS013B7DH05
+    const double bitset_ns = MeasureNs([]()
+    {
+        for (int row = 0; row < kRows; ++row)
+        {
+            DoNotOptimize(SwapWithBitset(row));
+        }
+    }, kRows);
+    const double table_ns = MeasureNs([]()
+    {
+        for (int row = 0; row < kRows; ++row)
+        {
+            uint8_t row_address = row;
+            DoNotOptimize(row_address);
+            DoNotOptimize(SwapWithTable(row_address));
+        }
+    }, kRows);
+
+    // Whole refresh, the SPI stub only copies the bytes
+    SharpMipDisplay display(144, 168, spi1, 17);
+    const double refresh_ns = MeasureNs([&display]()
+    {
+        display.RefreshScreen(0, kRows);
+        StubClearRecords();
+    });
+
+    std::printf("bitset and string: %8.2f ns per row, %8.0f ns per full refresh\n", bitset_ns, bitset_ns * kRows);
+    std::printf("lookup table:      %8.2f ns per row, %8.0f ns per full refresh\n", table_ns, table_ns * kRows);
+    std::printf("full refresh of 144x168 with the table, without SPI time: %.0f ns\n", refresh_ns);
+    return 0;
+}
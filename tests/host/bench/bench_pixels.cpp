@@ -0,0 +1,87 @@
+// Per-pixel drawing of a 144x168 checkerboard through the virtual Display, the runtime SharpMipDisplay and StaticDisplay<SharpMipDisplayT>
+
+#include <algorithm>
+#include "sharp_mip_display.h"
+#include "sharp_mip_display_t.h"
+#include "static_display.h"
+#include "bench.h"
+
+static constexpr uint16_t kWidth{144};
+static constexpr uint16_t kHeight{168};
+static constexpr double kPixels{kWidth * kHeight};
+
+// noinline keeps the compiler from seeing the dynamic type of the display
+__attribute__((noinline)) static void DrawWithDisplay(Display& display, int phase)
+{
+    for (uint16_t y = 0; y < kHeight; ++y)
+    {
+        for (uint16_t x = 0; x < kWidth; ++x)
+        {
+            if((x ^ y ^ phase) & 1)
+            {
+                display.SetPixel(x, y);
+            }
+            else
+            {
+                display.ResetPixel(x, y);
+            }
+        }
+    }
+}
+
+__attribute__((noinline)) static void DrawWithSharpMipDisplay(SharpMipDisplay& display, int phase)
+{
+    for (uint16_t y = 0; y < kHeight; ++y)
+    {
+        for (uint16_t x = 0; x < kWidth; ++x)
+        {
+            if((x ^ y ^ phase) & 1)
+            {
+                display.SetPixel(x, y);
+            }
+            else
+            {
+                display.ResetPixel(x, y);
+            }
+        }
+    }
+}
+
+template <typename Derived>
+__attribute__((noinline)) static void DrawWithStaticDisplay(StaticDisplay<Derived>& display, int phase)
+{
+    for (uint16_t y = 0; y < display.Height(); ++y)
+    {
+        for (uint16_t x = 0; x < display.Width(); ++x)
+        {
+            display.DrawPixel(x, y, (x ^ y ^ phase) & 1);
+        }
+    }
+}
+
+static SharpMipDisplay144x168 static_display(spi1, 18);
+
+int main()
+{
+    SharpMipDisplay runtime_display(kWidth, kHeight, spi1, 17);
+    int phase{0};
+
+    // Variants take turns, so a change of the CPU clock affects all of them
+    double display_runtime_ns{1e300};
+    double display_static_ns{1e300};
+    double runtime_ns{1e300};
+    double static_ns{1e300};
+    for (int round = 0; round < 40; ++round)
+    {
+        display_runtime_ns = std::min(display_runtime_ns, MeasureNs([&]() { DrawWithDisplay(runtime_display, ++phase); }, kPixels, 20, 1));
+        display_static_ns = std::min(display_static_ns, MeasureNs([&]() { DrawWithDisplay(static_display, ++phase); }, kPixels, 20, 1));
+        runtime_ns = std::min(runtime_ns, MeasureNs([&]() { DrawWithSharpMipDisplay(runtime_display, ++phase); }, kPixels, 20, 1));
+        static_ns = std::min(static_ns, MeasureNs([&]() { DrawWithStaticDisplay(static_display, ++phase); }, kPixels, 20, 1));
+    }
+
+    std::printf("Display& to SharpMipDisplay:               %5.2f ns per pixel\n", display_runtime_ns);
+    std::printf("Display& to SharpMipDisplay144x168:        %5.2f ns per pixel\n", display_static_ns);
+    std::printf("SharpMipDisplay&:                          %5.2f ns per pixel\n", runtime_ns);
+    std::printf("StaticDisplay<SharpMipDisplay144x168>:     %5.2f ns per pixel\n", static_ns);
+    return 0;
+}
@@ -0,0 +1,49 @@
+// DrawLineOfTextAtPixel() at a shifted column against DrawLineOfText() at a byte aligned column, for all raw fonts
+
+#include <algorithm>
+#include <string>
+#include "sharp_mip_display.h"
+#include "fonts/font_8x10.h"
+#include "fonts/font_16x20.h"
+#include "fonts/font_24x30.h"
+#include "fonts/font_32x40.h"
+#include "bench.h"
+
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+
+struct Font
+{
+    const char* name;
+    const uint8_t* table;
+};
+
+int main()
+{
+    const Font fonts[]{
+        {"8x10", kFont_8_10},
+        {"16x20", kFont_16_20},
+        {"24x30", kFont_24_30},
+        {"32x40", kFont_32_40},
+    };
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17);
+
+    for (const Font& font : fonts)
+    {
+        // One glyph less than fits, so the shifted text stays on the screen
+        const uint8_t glyph_width_in_bytes{font.table[0]};
+        const std::string text = std::string("Sharp MIP 0123456789 abcdefghijklmnopqrstuvwxyz").substr(0, kWidth / 8 / glyph_width_in_bytes - 1);
+        const double pixels = text.size() * glyph_width_in_bytes * 8.0 * font.table[1];
+
+        double aligned_ns{1e300};
+        double shifted_ns{1e300};
+        for (int round = 0; round < 40; ++round)
+        {
+            aligned_ns = std::min(aligned_ns, MeasureNs([&]() { display.DrawLineOfText(1, 20, text, font.table, Display::Mode::kMix); }, pixels, 50, 1));
+            shifted_ns = std::min(shifted_ns, MeasureNs([&]() { display.DrawLineOfTextAtPixel(11, 20, text, font.table, Display::Mode::kMix); }, pixels, 50, 1));
+        }
+        std::printf("%-6s DrawLineOfText %6.3f ns per pixel, DrawLineOfTextAtPixel %6.3f ns per pixel, ratio %.2f\n",
+                    font.name, aligned_ns, shifted_ns, shifted_ns / aligned_ns);
+    }
+    return 0;
+}
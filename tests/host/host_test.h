@@ -0,0 +1,30 @@
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <cstdio>
+
+// Failed checks are printed and counted, main() returns TestResult()
+static int test_failures{0};
+
+#define CHECK(condition) \
+    do \
+    { \
+        if(!(condition)) \
+        { \
+            ++test_failures; \
+            std::printf("%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition); \
+        } \
+    } while(false)
+
+static inline int TestResult()
+{
+    if(test_failures > 0)
+    {
+        std::printf("%d checks failed\n", test_failures);
+        return 1;
+    }
+    return 0;
+}
+
+
+#endif // HOST_TEST_H
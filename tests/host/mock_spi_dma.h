@@ -0,0 +1,92 @@
+#ifndef MOCK_SPI_DMA_H
+#define MOCK_SPI_DMA_H
+
+#include <atomic>
+#include <vector>
+#include "hardware/spi.h"
+#include "spi_dma.h"
+
+/**
+ * @brief SpiDma which writes the segments with spi_write_blocking() of the host stubs, so they are recorded in the transaction
+ * of the chip select pin which is high. Like a DMA channel, it reads the segments when it sends them, not when the transfer starts.
+ *
+ */
+class MockSpiDma : public SpiDma
+{
+public:
+
+    enum class Completion
+    {
+        kImmediate,     // StartTransfer() sends all segments and calls the completion handler before it returns
+        kDeferred,      // Complete() sends them and calls the handler, e.g. from another thread as an interrupt would
+    };
+
+    MockSpiDma(spi_inst_t* spi, Completion completion)
+    : kSPI_{spi}, kCompletion_{completion}
+    {
+    }
+
+    void StartTransfer(const Segment segments[], size_t amount_of_segments) override
+    {
+        segments_.assign(segments, segments + amount_of_segments);
+        ++transfers_started_;
+        pending_ = true;
+        if(kCompletion_ == Completion::kImmediate)
+        {
+            Complete();
+        }
+    }
+
+    /**
+     * @brief Sends the pending transfer and reports its completion.
+     *
+     * @return false if no transfer was pending.
+     */
+    bool Complete()
+    {
+        if(!pending_)
+        {
+            return false;
+        }
+        for (const Segment& segment : segments_)
+        {
+            spi_write_blocking(kSPI_, segment.data, segment.length);
+        }
+        pending_ = false;
+        ++transfers_completed_;
+        TransferComplete();
+        return true;
+    }
+
+    bool IsPending() const
+    {
+        return pending_;
+    }
+
+    size_t TransfersStarted() const
+    {
+        return transfers_started_;
+    }
+
+    size_t TransfersCompleted() const
+    {
+        return transfers_completed_;
+    }
+
+    const std::vector<Segment>& Segments() const
+    {
+        return segments_;
+    }
+
+private:
+
+    spi_inst_t* const kSPI_;
+    const Completion kCompletion_;
+    std::vector<Segment> segments_;
+    std::atomic<bool> pending_{false};
+    std::atomic<size_t> transfers_started_{0};
+    std::atomic<size_t> transfers_completed_{0};
+};
+
+
+#endif // MOCK_SPI_DMA_H
@@ -0,0 +1,143 @@
+#ifndef PANEL_MODEL_H
+#define PANEL_MODEL_H
+
+#include <stdint.h>
+#include <algorithm>
+#include <string>
+#include <vector>
+#include "host_stub.h"
+
+/**
+ * @brief Memory of a Sharp memory display, updated by decoding the recorded SPI transactions like the panel does.
+ * Pixels are stored as they are sent, 1 bit per pixel, 1 is white, the MSB is the leftmost pixel.
+ *
+ */
+class PanelModel
+{
+public:
+
+    PanelModel(uint16_t width, uint16_t height, uint cs_pin)
+    : kWidth_{width}, kHeight_{height}, kCsPin_{cs_pin}, pixels_(width / 8 * height, 0xFF)
+    {
+    }
+
+    /**
+     * @brief Decodes all transactions of the panel recorded since the previous call.
+     *
+     * @return number of decoded transactions.
+     */
+    size_t Receive()
+    {
+        size_t received{0};
+        const std::vector<StubTransaction>& transactions = StubTransactions();
+        if(next_transaction_ > transactions.size())
+        {
+            // Records were cleared
+            next_transaction_ = 0;
+        }
+        for (; next_transaction_ < transactions.size(); ++next_transaction_)
+        {
+            if(transactions[next_transaction_].cs_pin == kCsPin_)
+            {
+                Decode(transactions[next_transaction_].data);
+                ++received;
+            }
+        }
+        return received;
+    }
+
+    bool IsWhite(uint16_t x, uint16_t y) const
+    {
+        return (pixels_[y * (kWidth_ / 8) + x / 8] >> (7 - x % 8)) & 1;
+    }
+
+    const uint8_t* Row(uint16_t y) const
+    {
+        return &pixels_[y * (kWidth_ / 8)];
+    }
+
+    // Rows written by the last line write command, in the order they were sent
+    const std::vector<uint16_t>& LastRows() const
+    {
+        return last_rows_;
+    }
+
+    // VCOM bit of every command, in the order they were sent
+    const std::vector<bool>& VcomHistory() const
+    {
+        return vcom_history_;
+    }
+
+    // Description of the first malformed packet, empty if all packets were valid
+    const std::string& Error() const
+    {
+        return error_;
+    }
+
+private:
+
+    void Decode(const std::vector<uint8_t>& data)
+    {
+        // Line write has the M0 bit, VCOM and clear commands are 2 bytes long
+        if(data.size() < 2 || (!(data[0] & 0x80) && (data.size() != 2 || data[1] != 0)))
+        {
+            SetError("packet of " + std::to_string(data.size()) + " bytes");
+            return;
+        }
+        vcom_history_.push_back(data[0] & 0x40);
+        if(data[0] & 0x80)
+        {
+            DecodeLines(data);
+        }
+        else if(data[0] & 0x20)
+        {
+            std::fill(pixels_.begin(), pixels_.end(), 0xFF);
+        }
+    }
+
+    void DecodeLines(const std::vector<uint8_t>& data)
+    {
+        const size_t line_length = 1 + kWidth_ / 8 + 1;
+        if((data.size() - 2) % line_length != 0 || data.back() != 0)
+        {
+            SetError("line packet of " + std::to_string(data.size()) + " bytes");
+            return;
+        }
+        last_rows_.clear();
+        for (size_t i = 1; i + 1 < data.size(); i += line_length)
+        {
+            uint8_t address{0};
+            for (int bit = 0; bit < 8; ++bit)
+            {
+                address |= ((data[i] >> bit) & 1) << (7 - bit);
+            }
+            if(address >= kHeight_ || data[i + line_length - 1] != 0)
+            {
+                SetError("line " + std::to_string(address));
+                return;
+            }
+            std::copy(&data[i + 1], &data[i + 1] + kWidth_ / 8, &pixels_[address * (kWidth_ / 8)]);
+            last_rows_.push_back(address);
+        }
+    }
+
+    void SetError(const std::string& error)
+    {
+        if(error_.empty())
+        {
+            error_ = error;
+        }
+    }
+
+    const uint16_t kWidth_;
+    const uint16_t kHeight_;
+    const uint kCsPin_;
+    std::vector<uint8_t> pixels_;
+    std::vector<uint16_t> last_rows_;
+    std::vector<bool> vcom_history_;
+    size_t next_transaction_{0};
+    std::string error_;
+};
+
+
+#endif // PANEL_MODEL_H
@@ -0,0 +1,128 @@
+#ifndef REFERENCE_SCREEN_H
+#define REFERENCE_SCREEN_H
+
+#include <stdint.h>
+#include <cstring>
+#include <vector>
+#include "sharp_mip_display.h"
+#include "panel_model.h"
+
+/**
+ * @brief Expected contents of the panel, changed one pixel at a time. Tests draw the same shapes on the display and here,
+ * flush the display and compare the rows the panel received. Same format as PanelModel: 1 is white, the MSB is the leftmost pixel.
+ *
+ */
+class ReferenceScreen
+{
+public:
+
+    ReferenceScreen(uint16_t width, uint16_t height)
+    : kWidth_{width}, kHeight_{height}, pixels_(width / 8 * height, 0xFF), dirty_rows_(height, false)
+    {
+    }
+
+    uint16_t Width() const
+    {
+        return kWidth_;
+    }
+
+    uint16_t Height() const
+    {
+        return kHeight_;
+    }
+
+    bool IsWhite(int x, int y) const
+    {
+        return (pixels_[y * (kWidth_ / 8) + x / 8] >> (7 - x % 8)) & 1;
+    }
+
+    // Pixels outside of the screen are ignored, the row of a pixel inside becomes dirty even if the pixel does not change
+    void Put(int x, int y, bool white)
+    {
+        if(x < 0 || x >= kWidth_ || y < 0 || y >= kHeight_)
+        {
+            return;
+        }
+        uint8_t& pixels = pixels_[y * (kWidth_ / 8) + x / 8];
+        const uint8_t mask = 0b10000000 >> (x % 8);
+        pixels = white ? (pixels | mask) : (pixels & ~mask);
+        dirty_rows_[y] = true;
+    }
+
+    void Apply(int x, int y, SharpMipDisplay::PixelOp op)
+    {
+        if(x < 0 || x >= kWidth_ || y < 0 || y >= kHeight_)
+        {
+            return;
+        }
+        switch (op)
+        {
+        case SharpMipDisplay::PixelOp::kSet:
+            Put(x, y, false);
+            break;
+        case SharpMipDisplay::PixelOp::kClear:
+            Put(x, y, true);
+            break;
+        case SharpMipDisplay::PixelOp::kInvert:
+            Put(x, y, !IsWhite(x, y));
+            break;
+        }
+    }
+
+    // Smallest range of rows which contains all dirty rows, {0, 0} if no row is dirty
+    SharpMipDisplay::LineRange DirtyRange() const
+    {
+        uint16_t start{kHeight_};
+        uint16_t end{0};
+        for (uint16_t y = 0; y < kHeight_; ++y)
+        {
+            if(dirty_rows_[y])
+            {
+                start = std::min(start, y);
+                end = y + 1;
+            }
+        }
+        if(end == 0)
+        {
+            return SharpMipDisplay::LineRange{0, 0};
+        }
+        return SharpMipDisplay::LineRange{static_cast<uint8_t>(start), static_cast<uint8_t>(end)};
+    }
+
+    /**
+     * @brief Flushes the display and checks that the panel received exactly the dirty rows and that they are the same as here.
+     * Dirty rows are cleared.
+     *
+     * @return true if the panel matches.
+     */
+    bool FlushMatches(SharpMipDisplay& display, PanelModel& panel)
+    {
+        display.Flush();
+        const bool received = panel.Receive() > 0;
+        std::vector<bool> sent_rows(kHeight_, false);
+        if(received)
+        {
+            for (uint16_t y : panel.LastRows())
+            {
+                sent_rows[y] = true;
+            }
+        }
+        bool matches = panel.Error().empty() && sent_rows == dirty_rows_;
+        for (uint16_t y = 0; y < kHeight_; ++y)
+        {
+            matches = matches && std::memcmp(panel.Row(y), &pixels_[y * (kWidth_ / 8)], kWidth_ / 8) == 0;
+        }
+        std::fill(dirty_rows_.begin(), dirty_rows_.end(), false);
+        return matches;
+    }
+
+private:
+
+    const uint16_t kWidth_;
+    const uint16_t kHeight_;
+    std::vector<uint8_t> pixels_;
+    std::vector<bool> dirty_rows_;
+};
+
+
+#endif // REFERENCE_SCREEN_H
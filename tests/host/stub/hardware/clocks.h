@@ -0,0 +1,14 @@
+#ifndef HOST_STUB_HARDWARE_CLOCKS_H
+#define HOST_STUB_HARDWARE_CLOCKS_H
+
+#include "pico/stdlib.h"
+
+enum clock_index
+{
+    clk_sys = 5,
+};
+
+uint32_t clock_get_hz(enum clock_index clk_index);
+
+
+#endif // HOST_STUB_HARDWARE_CLOCKS_H
@@ -0,0 +1,35 @@
+#ifndef HOST_STUB_HARDWARE_DMA_H
+#define HOST_STUB_HARDWARE_DMA_H
+
+#include "pico/stdlib.h"
+
+#define NUM_DMA_CHANNELS 12
+
+enum dma_channel_transfer_size
+{
+    DMA_SIZE_8 = 0,
+    DMA_SIZE_16 = 1,
+    DMA_SIZE_32 = 2,
+};
+
+typedef struct
+{
+    uint32_t ctrl;
+} dma_channel_config;
+
+int dma_claim_unused_channel(bool required);
+void dma_channel_unclaim(uint channel);
+dma_channel_config dma_channel_get_default_config(uint channel);
+void channel_config_set_transfer_data_size(dma_channel_config* config, enum dma_channel_transfer_size size);
+void channel_config_set_read_increment(dma_channel_config* config, bool incr);
+void channel_config_set_write_increment(dma_channel_config* config, bool incr);
+void channel_config_set_dreq(dma_channel_config* config, uint dreq);
+void dma_channel_configure(uint channel, const dma_channel_config* config, volatile void* write_addr, const volatile void* read_addr, uint32_t transfer_count, bool trigger);
+void dma_channel_set_irq0_enabled(uint channel, bool enabled);
+bool dma_channel_get_irq0_status(uint channel);
+void dma_channel_acknowledge_irq0(uint channel);
+void dma_channel_abort(uint channel);
+void dma_channel_transfer_from_buffer_now(uint channel, const volatile void* read_addr, uint32_t transfer_count);
+
+
+#endif // HOST_STUB_HARDWARE_DMA_H
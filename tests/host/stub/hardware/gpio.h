@@ -0,0 +1,22 @@
+#ifndef HOST_STUB_HARDWARE_GPIO_H
+#define HOST_STUB_HARDWARE_GPIO_H
+
+#include "pico/stdlib.h"
+
+#define GPIO_OUT 1
+#define GPIO_IN 0
+
+enum gpio_function
+{
+    GPIO_FUNC_SPI = 1,
+    GPIO_FUNC_PWM = 4,
+    GPIO_FUNC_SIO = 5,
+};
+
+void gpio_init(uint gpio);
+void gpio_set_dir(uint gpio, bool out);
+void gpio_set_function(uint gpio, enum gpio_function fn);
+void gpio_put(uint gpio, bool value);
+
+
+#endif // HOST_STUB_HARDWARE_GPIO_H
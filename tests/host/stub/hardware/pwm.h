@@ -0,0 +1,23 @@
+#ifndef HOST_STUB_HARDWARE_PWM_H
+#define HOST_STUB_HARDWARE_PWM_H
+
+#include "pico/stdlib.h"
+
+typedef struct
+{
+    uint32_t csr;
+    uint32_t div;
+    uint32_t top;
+} pwm_config;
+
+uint pwm_gpio_to_slice_num(uint gpio);
+pwm_config pwm_get_default_config();
+void pwm_config_set_phase_correct(pwm_config* config, bool phase_correct);
+void pwm_config_set_clkdiv(pwm_config* config, float div);
+void pwm_config_set_wrap(pwm_config* config, uint16_t wrap);
+void pwm_init(uint slice_num, pwm_config* config, bool start);
+void pwm_set_gpio_level(uint gpio, uint16_t level);
+void pwm_set_enabled(uint slice_num, bool enabled);
+
+
+#endif // HOST_STUB_HARDWARE_PWM_H
@@ -0,0 +1,25 @@
+#ifndef HOST_STUB_HARDWARE_SPI_H
+#define HOST_STUB_HARDWARE_SPI_H
+
+#include "pico/stdlib.h"
+
+typedef struct
+{
+    volatile uint32_t cr0, cr1, dr, sr, cpsr, imsc, ris, mis, icr, dmacr;
+} spi_hw_t;
+
+typedef struct spi_inst spi_inst_t;
+
+#define SPI_SSPICR_RORIC_BITS 0x00000001u
+
+extern spi_inst_t* spi0;
+extern spi_inst_t* spi1;
+
+int spi_write_blocking(spi_inst_t* spi, const uint8_t* src, size_t len);
+spi_hw_t* spi_get_hw(spi_inst_t* spi);
+bool spi_is_busy(const spi_inst_t* spi);
+bool spi_is_readable(const spi_inst_t* spi);
+uint spi_get_dreq(spi_inst_t* spi, bool is_tx);
+
+
+#endif // HOST_STUB_HARDWARE_SPI_H
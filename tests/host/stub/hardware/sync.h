@@ -0,0 +1,22 @@
+#ifndef HOST_STUB_HARDWARE_SYNC_H
+#define HOST_STUB_HARDWARE_SYNC_H
+
+#include "pico/stdlib.h"
+
+typedef volatile uint32_t spin_lock_t;
+
+// Spin locks are mutexes, __sev() and __wfe() share one event flag like the event registers of both cores
+uint spin_lock_claim_unused(bool required);
+void spin_lock_unclaim(uint lock_num);
+spin_lock_t* spin_lock_init(uint lock_num);
+uint spin_lock_get_num(spin_lock_t* lock);
+uint32_t spin_lock_blocking(spin_lock_t* lock);
+void spin_unlock(spin_lock_t* lock, uint32_t saved_irq);
+uint32_t save_and_disable_interrupts();
+void restore_interrupts(uint32_t status);
+void __sev();
+void __wfe();
+void __dmb();
+
+
+#endif // HOST_STUB_HARDWARE_SYNC_H
@@ -0,0 +1,445 @@
+#include "host_stub.h"
+#include <atomic>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+#include "pico/stdlib.h"
+#include "pico/time.h"
+#include "pico/multicore.h"
+#include "hardware/spi.h"
+#include "hardware/gpio.h"
+#include "hardware/pwm.h"
+#include "hardware/clocks.h"
+#include "hardware/sync.h"
+#include "hardware/dma.h"
+#include "hardware/irq.h"
+
+// Records are written by whichever thread sends, tests read them after WaitIdle()
+static std::vector<StubTransaction> transactions;
+static std::vector<StubEvent> events;
+static std::atomic<uint64_t> now_us{0};
+static uint32_t spi_byte_time_us{4};
+static uint64_t high_pins{0};
+static size_t writes_without_cs{0};
+static repeating_timer_t* repeating_timer{nullptr};
+
+// Core 1 and the event register shared by __sev() and __wfe()
+struct Core1Reset
+{
+};
+static std::thread core1;
+static std::mutex event_mutex;
+static std::condition_variable event_condition;
+static bool event_flag{false};
+static bool core1_reset{false};
+static thread_local bool is_core1{false};
+
+static std::mutex fifo_mutex;
+static std::condition_variable fifo_condition;
+static std::deque<uintptr_t> fifo;
+
+static constexpr uint kSpinLockCount{32};
+static std::mutex spin_locks[kSpinLockCount];
+static spin_lock_t spin_lock_words[kSpinLockCount];
+static bool spin_lock_claimed[kSpinLockCount];
+
+struct spi_inst
+{
+    spi_hw_t hw;
+};
+static spi_inst spi_instances[2];
+spi_inst_t* spi0 = &spi_instances[0];
+spi_inst_t* spi1 = &spi_instances[1];
+
+static void Record(StubEvent::Type type, uint32_t value)
+{
+    events.push_back(StubEvent{type, now_us.load(), value});
+}
+
+void StubAdvanceTime(uint64_t us)
+{
+    now_us += us;
+}
+
+void StubSetSpiByteTime(uint32_t us)
+{
+    spi_byte_time_us = us;
+}
+
+void StubClearRecords()
+{
+    transactions.clear();
+    events.clear();
+    writes_without_cs = 0;
+}
+
+const std::vector<StubTransaction>& StubTransactions()
+{
+    return transactions;
+}
+
+const std::vector<StubEvent>& StubEvents()
+{
+    return events;
+}
+
+size_t StubWritesWithoutCs()
+{
+    return writes_without_cs;
+}
+
+bool StubFireRepeatingTimer()
+{
+    if(repeating_timer == nullptr)
+    {
+        return false;
+    }
+    repeating_timer->callback(repeating_timer);
+    return true;
+}
+
+/********** pico/stdlib.h, pico/time.h **********/
+
+void sleep_ms(uint32_t ms)
+{
+    now_us += ms * uint64_t{1000};
+}
+
+void sleep_us(uint64_t us)
+{
+    now_us += us;
+}
+
+void busy_wait_us_32(uint32_t delay_us)
+{
+    Record(StubEvent::Type::kBusyWait, delay_us);
+    now_us += delay_us;
+}
+
+absolute_time_t get_absolute_time()
+{
+    return now_us.load();
+}
+
+void tight_loop_contents()
+{
+    std::this_thread::yield();
+}
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out)
+{
+    out->delay_us = delay_ms * int64_t{1000};
+    out->callback = callback;
+    out->user_data = user_data;
+    repeating_timer = out;
+    return true;
+}
+
+bool cancel_repeating_timer(repeating_timer_t* timer)
+{
+    if(repeating_timer != timer)
+    {
+        return false;
+    }
+    repeating_timer = nullptr;
+    return true;
+}
+
+/********** pico/multicore.h **********/
+
+void multicore_launch_core1(void (*entry)(void))
+{
+    multicore_reset_core1();
+    core1 = std::thread([entry]()
+    {
+        is_core1 = true;
+        try
+        {
+            entry();
+        }
+        catch(const Core1Reset&)
+        {
+        }
+    });
+}
+
+void multicore_reset_core1()
+{
+    if(!core1.joinable())
+    {
+        return;
+    }
+    {
+        std::lock_guard<std::mutex> lock(event_mutex);
+        core1_reset = true;
+    }
+    event_condition.notify_all();
+    core1.join();
+    std::lock_guard<std::mutex> lock(event_mutex);
+    core1_reset = false;
+    event_flag = false;
+}
+
+void multicore_fifo_push_blocking(uintptr_t data)
+{
+    std::lock_guard<std::mutex> lock(fifo_mutex);
+    fifo.push_back(data);
+    fifo_condition.notify_all();
+}
+
+uintptr_t multicore_fifo_pop_blocking()
+{
+    std::unique_lock<std::mutex> lock(fifo_mutex);
+    fifo_condition.wait(lock, []() { return !fifo.empty(); });
+    uintptr_t data = fifo.front();
+    fifo.pop_front();
+    return data;
+}
+
+/********** hardware/sync.h **********/
+
+uint spin_lock_claim_unused(bool required)
+{
+    for (uint i = 0; i < kSpinLockCount; ++i)
+    {
+        if(!spin_lock_claimed[i])
+        {
+            spin_lock_claimed[i] = true;
+            return i;
+        }
+    }
+    return required ? 0 : static_cast<uint>(-1);
+}
+
+void spin_lock_unclaim(uint lock_num)
+{
+    spin_lock_claimed[lock_num] = false;
+}
+
+spin_lock_t* spin_lock_init(uint lock_num)
+{
+    return &spin_lock_words[lock_num];
+}
+
+uint spin_lock_get_num(spin_lock_t* lock)
+{
+    return static_cast<uint>(lock - spin_lock_words);
+}
+
+uint32_t spin_lock_blocking(spin_lock_t* lock)
+{
+    spin_locks[spin_lock_get_num(lock)].lock();
+    return 0;
+}
+
+void spin_unlock(spin_lock_t* lock, uint32_t)
+{
+    spin_locks[spin_lock_get_num(lock)].unlock();
+}
+
+uint32_t save_and_disable_interrupts()
+{
+    return 0;
+}
+
+void restore_interrupts(uint32_t)
+{
+}
+
+void __sev()
+{
+    {
+        std::lock_guard<std::mutex> lock(event_mutex);
+        event_flag = true;
+    }
+    event_condition.notify_all();
+}
+
+void __wfe()
+{
+    std::unique_lock<std::mutex> lock(event_mutex);
+    event_condition.wait(lock, []() { return event_flag || core1_reset; });
+    if(core1_reset && std::this_thread::get_id() == core1.get_id())
+    {
+        throw Core1Reset{};
+    }
+    event_flag = false;
+}
+
+void __dmb()
+{
+    // Both cores are threads, they synchronize through the atomics and mutexes they use
+}
+
+/********** hardware/gpio.h, hardware/spi.h **********/
+
+void gpio_init(uint)
+{
+}
+
+void gpio_set_dir(uint, bool)
+{
+}
+
+void gpio_set_function(uint, enum gpio_function)
+{
+}
+
+void gpio_put(uint gpio, bool value)
+{
+    const uint64_t mask{uint64_t{1} << gpio};
+    if(value && !(high_pins & mask))
+    {
+        transactions.push_back(StubTransaction{gpio, {}, is_core1});
+    }
+    high_pins = value ? (high_pins | mask) : (high_pins & ~mask);
+    Record(value ? StubEvent::Type::kPinHigh : StubEvent::Type::kPinLow, gpio);
+}
+
+int spi_write_blocking(spi_inst_t*, const uint8_t* src, size_t len)
+{
+    Record(StubEvent::Type::kSpiWrite, static_cast<uint32_t>(len));
+    if(high_pins == 0)
+    {
+        ++writes_without_cs;
+    }
+    else
+    {
+        transactions.back().data.insert(transactions.back().data.end(), src, src + len);
+    }
+    now_us += len * spi_byte_time_us;
+    return static_cast<int>(len);
+}
+
+spi_hw_t* spi_get_hw(spi_inst_t* spi)
+{
+    return &spi->hw;
+}
+
+bool spi_is_busy(const spi_inst_t*)
+{
+    return false;
+}
+
+bool spi_is_readable(const spi_inst_t*)
+{
+    return false;
+}
+
+uint spi_get_dreq(spi_inst_t*, bool)
+{
+    return 0;
+}
+
+/********** hardware/pwm.h, hardware/clocks.h **********/
+
+uint pwm_gpio_to_slice_num(uint gpio)
+{
+    return (gpio >> 1) & 7;
+}
+
+pwm_config pwm_get_default_config()
+{
+    return pwm_config{};
+}
+
+void pwm_config_set_phase_correct(pwm_config*, bool)
+{
+}
+
+void pwm_config_set_clkdiv(pwm_config*, float)
+{
+}
+
+void pwm_config_set_wrap(pwm_config*, uint16_t)
+{
+}
+
+void pwm_init(uint, pwm_config*, bool)
+{
+}
+
+void pwm_set_gpio_level(uint, uint16_t)
+{
+}
+
+void pwm_set_enabled(uint, bool)
+{
+}
+
+uint32_t clock_get_hz(enum clock_index)
+{
+    return 125000000;
+}
+
+/********** hardware/dma.h, hardware/irq.h **********/
+
+// Rp2040SpiDma is only compiled, tests use MockSpiDma
+
+int dma_claim_unused_channel(bool)
+{
+    return 0;
+}
+
+void dma_channel_unclaim(uint)
+{
+}
+
+dma_channel_config dma_channel_get_default_config(uint)
+{
+    return dma_channel_config{};
+}
+
+void channel_config_set_transfer_data_size(dma_channel_config*, enum dma_channel_transfer_size)
+{
+}
+
+void channel_config_set_read_increment(dma_channel_config*, bool)
+{
+}
+
+void channel_config_set_write_increment(dma_channel_config*, bool)
+{
+}
+
+void channel_config_set_dreq(dma_channel_config*, uint)
+{
+}
+
+void dma_channel_configure(uint, const dma_channel_config*, volatile void*, const volatile void*, uint32_t, bool)
+{
+}
+
+void dma_channel_set_irq0_enabled(uint, bool)
+{
+}
+
+bool dma_channel_get_irq0_status(uint)
+{
+    return false;
+}
+
+void dma_channel_acknowledge_irq0(uint)
+{
+}
+
+void dma_channel_abort(uint)
+{
+}
+
+void dma_channel_transfer_from_buffer_now(uint, const volatile void*, uint32_t)
+{
+}
+
+void irq_add_shared_handler(uint, irq_handler_t, uint8_t)
+{
+}
+
+void irq_remove_handler(uint, irq_handler_t)
+{
+}
+
+void irq_set_enabled(uint, bool)
+{
+}
@@ -0,0 +1,73 @@
+#ifndef HOST_STUB_H
+#define HOST_STUB_H
+
+#include <vector>
+#include "pico/stdlib.h"
+
+/**
+ * @brief Everything written to the SPI while a chip select pin was high.
+ *
+ */
+struct StubTransaction
+{
+    uint cs_pin;
+    std::vector<uint8_t> data;
+    // Started by the thread which plays core 1
+    bool on_core1;
+};
+
+/**
+ * @brief Call of the stubbed SDK, with the time of the mock clock when it started.
+ *
+ */
+struct StubEvent
+{
+    enum class Type
+    {
+        kPinHigh,
+        kPinLow,
+        kSpiWrite,
+        kBusyWait,
+    };
+    Type type;
+    uint64_t time_us;
+    // Pin of kPinHigh and kPinLow, bytes of kSpiWrite, microseconds of kBusyWait
+    uint32_t value;
+};
+
+/**
+ * @brief Mock clock in microseconds. It moves only by busy waits, sleeps, SPI writes and StubAdvanceTime().
+ *
+ */
+void StubAdvanceTime(uint64_t us);
+
+/**
+ * @brief Sets how long spi_write_blocking() takes per byte, 4 us by default (2 MHz).
+ *
+ */
+void StubSetSpiByteTime(uint32_t us);
+
+/**
+ * @brief Forgets all transactions and events. The clock keeps running.
+ *
+ */
+void StubClearRecords();
+
+const std::vector<StubTransaction>& StubTransactions();
+const std::vector<StubEvent>& StubEvents();
+
+/**
+ * @brief Number of SPI writes while no pin was high, they are not part of any transaction.
+ *
+ */
+size_t StubWritesWithoutCs();
+
+/**
+ * @brief Calls the callback of the repeating timer added last, as its alarm interrupt would.
+ *
+ * @return false if there is no timer.
+ */
+bool StubFireRepeatingTimer();
+
+
+#endif // HOST_STUB_H
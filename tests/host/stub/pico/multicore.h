@@ -0,0 +1,14 @@
+#ifndef HOST_STUB_PICO_MULTICORE_H
+#define HOST_STUB_PICO_MULTICORE_H
+
+#include "pico/stdlib.h"
+
+// Core 1 is a std::thread, multicore_reset_core1() stops it at its next __wfe() and joins it
+void multicore_launch_core1(void (*entry)(void));
+void multicore_reset_core1();
+// The SDK passes uint32_t, which holds a pointer only on the RP2040
+void multicore_fifo_push_blocking(uintptr_t data);
+uintptr_t multicore_fifo_pop_blocking();
+
+
+#endif // HOST_STUB_PICO_MULTICORE_H
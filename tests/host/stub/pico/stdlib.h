@@ -0,0 +1,35 @@
+#ifndef HOST_STUB_PICO_STDLIB_H
+#define HOST_STUB_PICO_STDLIB_H
+
+// Subset of the Pico SDK used by the driver, implemented by host_stub.cpp
+
+#include <stdint.h>
+#include <stddef.h>
+#include <stdio.h>
+
+typedef unsigned int uint;
+typedef uint64_t absolute_time_t;
+
+void sleep_ms(uint32_t ms);
+void sleep_us(uint64_t us);
+void busy_wait_us_32(uint32_t delay_us);
+absolute_time_t get_absolute_time();
+void tight_loop_contents();
+
+static inline uint64_t time_us_64()
+{
+    return get_absolute_time();
+}
+
+static inline uint32_t time_us_32()
+{
+    return static_cast<uint32_t>(get_absolute_time());
+}
+
+static inline int64_t absolute_time_diff_us(absolute_time_t from, absolute_time_t to)
+{
+    return static_cast<int64_t>(to - from);
+}
+
+
+#endif // HOST_STUB_PICO_STDLIB_H
@@ -0,0 +1,20 @@
+#ifndef HOST_STUB_PICO_TIME_H
+#define HOST_STUB_PICO_TIME_H
+
+#include "pico/stdlib.h"
+
+typedef struct repeating_timer repeating_timer_t;
+typedef bool (*repeating_timer_callback_t)(repeating_timer_t* timer);
+
+struct repeating_timer
+{
+    int64_t delay_us;
+    repeating_timer_callback_t callback;
+    void* user_data;
+};
+
+bool add_repeating_timer_ms(int32_t delay_ms, repeating_timer_callback_t callback, void* user_data, repeating_timer_t* out);
+bool cancel_repeating_timer(repeating_timer_t* timer);
+
+
+#endif // HOST_STUB_PICO_TIME_H
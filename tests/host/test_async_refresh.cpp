@@ -0,0 +1,176 @@
+// Asynchronous refresh with MockSpiDma, completed immediately or later like a DMA interrupt
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <thread>
+#include "sharp_mip_display_t.h"
+#include "panel_model.h"
+#include "mock_spi_dma.h"
+#include "host_test.h"
+
+static constexpr uint kCsPin{17};
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+
+static const SharpMipDisplay::BufferLayout kLayouts[]{SharpMipDisplay::BufferLayout::kPacked, SharpMipDisplay::BufferLayout::kWire};
+
+static void CountRefresh(void* context)
+{
+    ++*static_cast<std::atomic<int>*>(context);
+}
+
+// Only the given rectangles are black
+static bool ShowsRects(const PanelModel& panel, std::initializer_list<std::array<int, 4>> rects)
+{
+    for (int y = 0; y < kHeight; ++y)
+    {
+        for (int x = 0; x < kWidth; ++x)
+        {
+            bool black{false};
+            for (const std::array<int, 4>& rect : rects)
+            {
+                black = black || (x >= rect[0] && x < rect[0] + rect[2] && y >= rect[1] && y < rect[1] + rect[3]);
+            }
+            if(panel.IsWhite(x, y) == black)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void TestImmediateCompletion(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, kCsPin);
+    MockSpiDma dma(spi1, MockSpiDma::Completion::kImmediate);
+    std::atomic<int> refreshes{0};
+    SharpMipDisplay display(kWidth, kHeight, spi1, kCsPin, layout);
+    display.EnableAsyncRefresh(&dma);
+    display.SetRefreshCallback(&CountRefresh, &refreshes);
+
+    display.FillRect(3, 10, 100, 5);
+    display.FillRect(200, 100, 30, 30);
+    display.Flush();
+    CHECK(!display.IsBusy());
+    CHECK(refreshes == 1);
+    CHECK(dma.TransfersCompleted() == 1);
+    CHECK(panel.Receive() == 1);
+    CHECK(panel.LastRows().size() == 35);
+    CHECK(ShowsRects(panel, {{3, 10, 100, 5}, {200, 100, 30, 30}}));
+
+    // Blocking refresh again after asynchronous refresh is disabled, then asynchronous once more
+    display.EnableAsyncRefresh(nullptr);
+    display.ClearRect(200, 100, 30, 30);
+    display.Flush();
+    CHECK(refreshes == 1);
+    CHECK(panel.Receive() == 1);
+    CHECK(panel.LastRows().size() == 30);
+    CHECK(ShowsRects(panel, {{3, 10, 100, 5}}));
+    display.EnableAsyncRefresh(&dma);
+    display.FillRect(0, 230, 400, 10);
+    display.Flush();
+    CHECK(refreshes == 2);
+    CHECK(panel.Receive() == 1);
+    CHECK(ShowsRects(panel, {{3, 10, 100, 5}, {0, 230, 400, 10}}));
+    CHECK(panel.Error().empty());
+    CHECK(StubWritesWithoutCs() == 0);
+}
+
+static void TestDeferredCompletion(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, kCsPin);
+    MockSpiDma dma(spi1, MockSpiDma::Completion::kDeferred);
+    std::atomic<int> refreshes{0};
+    SharpMipDisplay display(kWidth, kHeight, spi1, kCsPin, layout);
+    display.EnableAsyncRefresh(&dma);
+    display.SetRefreshCallback(&CountRefresh, &refreshes);
+
+    display.FillRect(0, 0, 400, 240);
+    display.Flush();
+    CHECK(display.IsBusy());
+    CHECK(dma.IsPending());
+    CHECK(refreshes == 0);
+
+    CHECK(dma.Complete());
+    CHECK(!display.IsBusy());
+    CHECK(refreshes == 1);
+    panel.Receive();
+    CHECK(ShowsRects(panel, {{0, 0, 400, 240}}));
+
+    // WaitIdle() returns when the interrupt, here another thread, completes the transfer
+    display.ClearRect(0, 0, 400, 240);
+    display.Flush();
+    std::thread interrupt([&dma]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        dma.Complete();
+    });
+    display.WaitIdle();
+    CHECK(dma.TransfersCompleted() == 2);
+    CHECK(refreshes == 2);
+    interrupt.join();
+
+    // The second refresh waits until the first one is completed, then starts its own transfer
+    display.FillRect(0, 0, 10, 10);
+    display.Flush();
+    interrupt = std::thread([&dma]()
+    {
+        std::this_thread::sleep_for(std::chrono::milliseconds(20));
+        dma.Complete();
+    });
+    display.FillRect(0, 200, 10, 10);
+    display.Flush();
+    CHECK(dma.TransfersCompleted() == 3);
+    CHECK(dma.TransfersStarted() == 4);
+    CHECK(display.IsBusy());
+    interrupt.join();
+    CHECK(dma.Complete());
+    CHECK(refreshes == 4);
+
+    panel.Receive();
+    CHECK(panel.LastRows().size() == 10);
+    CHECK(ShowsRects(panel, {{0, 0, 10, 10}, {0, 200, 10, 10}}));
+    CHECK(panel.Error().empty());
+    CHECK(StubWritesWithoutCs() == 0);
+}
+
+// The packet of the packed layout and the rows of the wire layout are sent from SharpMipDisplayT, not from the heap
+template <SharpMipDisplay::BufferLayout kLayout>
+static void TestStaticStorage()
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, kCsPin);
+    MockSpiDma dma(spi1, MockSpiDma::Completion::kImmediate);
+    static SharpMipDisplayT<kWidth, kHeight, kLayout> display(spi1, kCsPin);
+    display.EnableAsyncRefresh(&dma);
+
+    display.FillRect(10, 20, 50, 6);
+    display.Flush();
+    CHECK(panel.Receive() == 1);
+    CHECK(ShowsRects(panel, {{10, 20, 50, 6}}));
+    const uint8_t* const begin = reinterpret_cast<const uint8_t*>(&display);
+    const uint8_t* const end = reinterpret_cast<const uint8_t*>(&display + 1);
+    for (const SpiDma::Segment& segment : dma.Segments())
+    {
+        // The final trailer is a constant of SharpMipDisplay
+        CHECK(segment.length == 1 || (segment.data >= begin && segment.data + segment.length <= end));
+    }
+    CHECK(panel.Error().empty());
+    display.EnableAsyncRefresh(nullptr);
+}
+
+int main()
+{
+    for (SharpMipDisplay::BufferLayout layout : kLayouts)
+    {
+        TestImmediateCompletion(layout);
+        TestDeferredCompletion(layout);
+    }
+    TestStaticStorage<SharpMipDisplay::BufferLayout::kPacked>();
+    TestStaticStorage<SharpMipDisplay::BufferLayout::kWire>();
+    return TestResult();
+}
@@ -0,0 +1,102 @@
+// BlitBitmap() with every raster op against a per-pixel reference, in both buffer layouts. Bitmaps are allocated with their exact
+// size, so AddressSanitizer catches reads past their end.
+
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+#include "sharp_mip_display.h"
+#include "panel_model.h"
+#include "reference_screen.h"
+#include "host_test.h"
+
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+
+static bool Combine(bool screen, bool bitmap, SharpMipDisplay::RasterOp op)
+{
+    switch (op)
+    {
+    case SharpMipDisplay::RasterOp::kCopy:
+        return bitmap;
+    case SharpMipDisplay::RasterOp::kAnd:
+        return screen && bitmap;
+    case SharpMipDisplay::RasterOp::kOr:
+        return screen || bitmap;
+    case SharpMipDisplay::RasterOp::kXor:
+        return screen != bitmap;
+    case SharpMipDisplay::RasterOp::kAndNot:
+        return screen && !bitmap;
+    }
+    return screen;
+}
+
+static SharpMipDisplay::LineRange Blit(SharpMipDisplay& display, ReferenceScreen& reference, int16_t x, int16_t y,
+                                       const std::vector<uint8_t>& bitmap, uint16_t width, uint16_t height, uint16_t stride,
+                                       SharpMipDisplay::RasterOp op)
+{
+    uint8_t* exact_bitmap = new uint8_t[bitmap.size()];
+    std::memcpy(exact_bitmap, bitmap.data(), bitmap.size());
+    const SharpMipDisplay::LineRange range = display.BlitBitmap(x, y, exact_bitmap, width, height, stride, op);
+    delete[] exact_bitmap;
+
+    for (int j = 0; j < height; ++j)
+    {
+        for (int i = 0; i < width; ++i)
+        {
+            const int column = x + i;
+            const int row = y + j;
+            if(column >= 0 && column < kWidth && row >= 0 && row < kHeight)
+            {
+                const bool white = (bitmap[j * stride + i / 8] >> (7 - i % 8)) & 1;
+                reference.Put(column, row, Combine(reference.IsWhite(column, row), white, op));
+            }
+        }
+    }
+    return range;
+}
+
+static void TestBlitBitmap(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    ReferenceScreen reference(kWidth, kHeight);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17, layout);
+    std::srand(9);
+
+    // Random background, so every op changes some pixels
+    std::vector<uint8_t> background(kWidth / 8 * kHeight);
+    for (uint8_t& pixels : background)
+    {
+        pixels = std::rand();
+    }
+    Blit(display, reference, 0, 0, background, kWidth, kHeight, kWidth / 8, SharpMipDisplay::RasterOp::kCopy);
+    CHECK(reference.FlushMatches(display, panel));
+
+    for (int i = 0; i < 3000; ++i)
+    {
+        // Mostly small bitmaps, some wider than the screen and some with padding at the end of rows
+        const uint16_t width = std::rand() % ((i % 5 != 0) ? 70 : 300) + ((i % 11 != 0) ? 1 : 0);
+        const uint16_t height = std::rand() % 50 + 1;
+        const uint16_t stride = (width + 7) / 8 + std::rand() % 3;
+        const int16_t x = std::rand() % 520 - 80;
+        const int16_t y = std::rand() % 320 - 60;
+        const SharpMipDisplay::RasterOp op = static_cast<SharpMipDisplay::RasterOp>(std::rand() % 5);
+        std::vector<uint8_t> bitmap(std::max(stride * height, 1));
+        for (uint8_t& pixels : bitmap)
+        {
+            pixels = std::rand();
+        }
+
+        const SharpMipDisplay::LineRange range = Blit(display, reference, x, y, bitmap, width, height, stride, op);
+        const SharpMipDisplay::LineRange expected = reference.DirtyRange();
+        CHECK(range.start == expected.start && range.end == expected.end);
+        CHECK(reference.FlushMatches(display, panel));
+    }
+}
+
+int main()
+{
+    TestBlitBitmap(SharpMipDisplay::BufferLayout::kPacked);
+    TestBlitBitmap(SharpMipDisplay::BufferLayout::kWire);
+    return TestResult();
+}
@@ -0,0 +1,78 @@
+// ClearScreen() sends the clear command at once, or defers it to the next refresh or Present()
+
+#include "sharp_mip_display.h"
+#include "panel_model.h"
+#include "host_test.h"
+
+static constexpr uint kCsPin{17};
+
+static bool IsPanelWhite(const PanelModel& panel)
+{
+    for (int y = 0; y < 168; ++y)
+    {
+        for (int x = 0; x < 144; ++x)
+        {
+            if(!panel.IsWhite(x, y))
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void TestImmediateClear()
+{
+    StubClearRecords();
+    PanelModel panel(144, 168, kCsPin);
+    SharpMipDisplay display(144, 168, spi1, kCsPin);
+    display.FillRect(10, 10, 20, 20);
+    display.Flush();
+    panel.Receive();
+    CHECK(!panel.IsWhite(10, 10));
+
+    display.ClearScreen();
+    CHECK(panel.Receive() == 1);
+    CHECK(IsPanelWhite(panel));
+}
+
+static void TestClearWithDoubleBuffering()
+{
+    StubClearRecords();
+    PanelModel panel(144, 168, kCsPin);
+    SharpMipDisplay display(144, 168, spi1, kCsPin);
+    display.EnableDoubleBuffering(true);
+    display.FillRect(10, 10, 20, 20);
+    display.Present();
+    panel.Receive();
+    CHECK(!panel.IsWhite(10, 10));
+
+    // The front buffer is still shown until Present()
+    display.ClearScreen();
+    display.FillRect(50, 50, 4, 4);
+    CHECK(panel.Receive() == 0);
+    display.RefreshScreen(0, 168);
+    panel.Receive();
+    CHECK(!panel.IsWhite(10, 10));
+    CHECK(panel.IsWhite(50, 50));
+
+    display.Present();
+    panel.Receive();
+    CHECK(panel.IsWhite(10, 10));
+    CHECK(!panel.IsWhite(50, 50));
+
+    // The new back buffer is cleared too, so refreshing the front buffer again shows the same frame
+    display.Present();
+    display.RefreshScreen(0, 168);
+    panel.Receive();
+    CHECK(panel.IsWhite(10, 10));
+    CHECK(!panel.IsWhite(50, 50));
+    CHECK(panel.Error().empty());
+}
+
+int main()
+{
+    TestImmediateClear();
+    TestClearWithDoubleBuffering();
+    return TestResult();
+}
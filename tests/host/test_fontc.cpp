@@ -0,0 +1,15 @@
+// fontc converts tools/fontc/font_8x10.bdf with --pad-left 2 into the same table as sharp-mip/fonts/font_8x10.h
+
+#include <algorithm>
+#include <cstdint>
+#include "fonts/font_8x10.h"
+#include "font_8x10_fontc.h"
+#include "host_test.h"
+
+int main()
+{
+    CHECK(sizeof(kFont_8_10) == 953);
+    CHECK(sizeof(kFont_8_10_Fontc) == sizeof(kFont_8_10));
+    CHECK(std::equal(kFont_8_10, kFont_8_10 + std::min(sizeof(kFont_8_10), sizeof(kFont_8_10_Fontc)), kFont_8_10_Fontc));
+    return TestResult();
+}
@@ -0,0 +1,253 @@
+// Fonts from the opt-in headers: compressed fonts draw the same pixels as the raw ones, proportional fonts draw narrower text
+
+#include <algorithm>
+#include <vector>
+#include "sharp_mip_display.h"
+#include "glyph_cache.h"
+#include "fonts/font_8x10_compressed.h"
+#include "fonts/font_16x20_compressed.h"
+#include "fonts/font_24x30_compressed.h"
+#include "fonts/font_32x40_compressed.h"
+#include "fonts/font_8x10_proportional.h"
+#include "fonts/font_16x20_proportional.h"
+#include "fonts/font_24x30_proportional.h"
+#include "fonts/font_32x40_proportional.h"
+#include "panel_model.h"
+#include "host_test.h"
+
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+static const std::string kText{"Ag0 ~}"};
+
+static bool SamePanels(const PanelModel& first, const PanelModel& second)
+{
+    for (int y = 0; y < kHeight; ++y)
+    {
+        if(!std::equal(first.Row(y), first.Row(y) + kWidth / 8, second.Row(y)))
+        {
+            return false;
+        }
+    }
+    return true;
+}
+
+static void TestCompressedFont(const uint8_t raw_font[], const uint8_t compressed_font[])
+{
+    StubClearRecords();
+    PanelModel raw_panel(kWidth, kHeight, 17);
+    PanelModel compressed_panel(kWidth, kHeight, 18);
+    SharpMipDisplay raw(kWidth, kHeight, spi1, 17);
+    SharpMipDisplay compressed(kWidth, kHeight, spi1, 18);
+
+    raw.DrawLineOfText(1, 5, kText, raw_font, Display::Mode::kMix);
+    raw.DrawLineOfTextAtPixel(13, 100, kText, raw_font, Display::Mode::kMix);
+    raw.Flush();
+    raw_panel.Receive();
+    compressed.DrawLineOfText(1, 5, kText, compressed_font, Display::Mode::kMix);
+    compressed.DrawLineOfTextAtPixel(13, 100, kText, compressed_font, Display::Mode::kMix);
+    compressed.Flush();
+    compressed_panel.Receive();
+    CHECK(SamePanels(raw_panel, compressed_panel));
+}
+
+// Stripes under the text, so the pixels which text keeps or erases around it differ from the ones it draws
+static void DrawBackground(SharpMipDisplay& display)
+{
+    display.ClearRect(0, 0, kWidth, kHeight);
+    for (uint16_t x = 0; x < kWidth; x += 3)
+    {
+        display.InvertRect(x, 0, 1, kHeight);
+    }
+    for (uint16_t y = 0; y < kHeight; y += 5)
+    {
+        display.InvertRect(0, y, kWidth, 2);
+    }
+}
+
+// Raw fonts are shifted several rows at once, compressed fonts glyph by glyph: both draw the same pixels at every shift, in every
+// mode, with more characters than one run and with rows cut off at the bottom of the screen
+static void TestShiftedText(const uint8_t raw_font[], const uint8_t compressed_font[])
+{
+    StubClearRecords();
+    PanelModel raw_panel(kWidth, kHeight, 17);
+    PanelModel compressed_panel(kWidth, kHeight, 18);
+    SharpMipDisplay raw(kWidth, kHeight, spi1, 17);
+    SharpMipDisplay compressed(kWidth, kHeight, spi1, 18);
+    std::string text;
+    while(text.size() < 60)
+    {
+        text += "0123456789 Ag~} " + kText;
+    }
+
+    const uint16_t glyph_width = raw_font[0] * 8;
+    for (const Display::Mode mode : {Display::Mode::kAdd, Display::Mode::kMix, Display::Mode::kReplace})
+    {
+        for (const uint16_t x : {9, 10, 11, 12, 13, 14, 15, 3, kWidth - 2 * glyph_width - 13, kWidth - glyph_width - 9})
+        {
+            for (const uint16_t y : {60, kHeight - 7})
+            {
+                DrawBackground(raw);
+                DrawBackground(compressed);
+                raw.DrawLineOfTextAtPixel(x, y, text, raw_font, mode);
+                compressed.DrawLineOfTextAtPixel(x, y, text, compressed_font, mode);
+                raw.Flush();
+                raw_panel.Receive();
+                compressed.Flush();
+                compressed_panel.Receive();
+                CHECK(SamePanels(raw_panel, compressed_panel));
+            }
+        }
+    }
+}
+
+// Compressed text drawn with a cache of 4 glyphs is the same as without it, when glyphs are found, shifted and replaced.
+// Raw fonts are shifted straight from the font and do not use the cache.
+static void TestGlyphCache(const uint8_t raw_font[], const uint8_t compressed_font[])
+{
+    StubClearRecords();
+    PanelModel cached_panel(kWidth, kHeight, 17);
+    PanelModel uncached_panel(kWidth, kHeight, 18);
+    SharpMipDisplay cached(kWidth, kHeight, spi1, 17);
+    SharpMipDisplay uncached(kWidth, kHeight, spi1, 18);
+    GlyphCache cache(4, 5 * 40);
+    cached.EnableGlyphCache(&cache);
+
+    const std::string texts[]{"12:00", "12:00", kText + "0123456789", "12:00", "12:00"};
+    for (const Display::Mode mode : {Display::Mode::kAdd, Display::Mode::kMix, Display::Mode::kReplace})
+    {
+        for (const uint16_t x : {9, 11, 12, 15})
+        {
+            for (const std::string& text : texts)
+            {
+                DrawBackground(cached);
+                DrawBackground(uncached);
+                cached.DrawLineOfTextAtPixel(x, 60, text, compressed_font, mode);
+                uncached.DrawLineOfTextAtPixel(x, 60, text, compressed_font, mode);
+                cached.Flush();
+                cached_panel.Receive();
+                uncached.Flush();
+                uncached_panel.Receive();
+                CHECK(SamePanels(cached_panel, uncached_panel));
+            }
+        }
+    }
+    // The last text is cached, 4 other glyphs replace all of it
+    cache.ResetCounters();
+    cached.DrawLineOfTextAtPixel(15, 60, "12:00", compressed_font, Display::Mode::kMix);
+    CHECK(cache.GetHits() == 5 && cache.GetMisses() == 0);
+    cached.DrawLineOfTextAtPixel(15, 60, "3456", compressed_font, Display::Mode::kMix);
+    cached.DrawLineOfTextAtPixel(15, 60, "12:00", compressed_font, Display::Mode::kMix);
+    CHECK(cache.GetHits() == 6 && cache.GetMisses() == 8);
+
+    const uint32_t uses = cache.GetHits() + cache.GetMisses();
+    cached.DrawLineOfTextAtPixel(11, 60, kText, raw_font, Display::Mode::kMix);
+    CHECK(cache.GetHits() + cache.GetMisses() == uses);
+}
+
+// Text is narrower than in the raw font, and all of its black pixels are within the width returned by GetTextWidth()
+static void TestProportionalFont(const uint8_t raw_font[], const uint8_t proportional_font[])
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17);
+    const uint16_t width = SharpMipDisplay::GetTextWidth(kText, proportional_font);
+    CHECK(width > 0 && width < SharpMipDisplay::GetTextWidth(kText, raw_font));
+
+    const uint16_t x{13};
+    display.DrawLineOfTextAtPixel(x, 5, kText, proportional_font, Display::Mode::kMix);
+    display.Flush();
+    panel.Receive();
+    int black{0};
+    int outside{0};
+    for (int y = 0; y < kHeight; ++y)
+    {
+        for (int column = 0; column < kWidth; ++column)
+        {
+            if(!panel.IsWhite(column, y))
+            {
+                ++black;
+                outside += (column < x || column >= x + width);
+            }
+        }
+    }
+    CHECK(black > 0);
+    CHECK(outside == 0);
+
+    // The width in the header is the widest glyph, spacing included
+    uint8_t widest_glyph_in_bytes{0};
+    for (int character = proportional_font[2]; character < proportional_font[2] + proportional_font[3]; ++character)
+    {
+        widest_glyph_in_bytes = std::max<uint8_t>(widest_glyph_in_bytes, (ProportionalGlyphAdvance(proportional_font, character) + 7) / 8);
+    }
+    CHECK(FontWidthInBytes(proportional_font) == widest_glyph_in_bytes);
+}
+
+// A glyph of one black byte with 2 pixels of spacing is 10 pixels wide, wider than the cell of the raw font
+static constexpr uint8_t kSolidFont[]{1, 1, 'A', 0b00000000};
+
+static void TestProportionalWidth()
+{
+    constexpr auto kSolidProportional = MakeProportionalFont<ProportionalFontSize(kSolidFont, 2)>(kSolidFont, 2);
+    CHECK(ProportionalGlyphAdvance(kSolidProportional.data(), 'A') == 10);
+    CHECK(FontWidthInBytes(kSolidProportional.data()) == 2);
+}
+
+// 'A' is 5 pixels wide, 'B' 10. Pair "AB" is 2 pixels closer, "BA" 1 pixel, so the glyphs overlap and are merged.
+static const uint8_t kKernedFont[]{
+    kProportionalFontFlag | 2, 2, 'A', 2, 2,
+    0, 0, 5,
+    2, 0, 10,
+    'A', 'B', static_cast<uint8_t>(-2),
+    'B', 'A', static_cast<uint8_t>(-1),
+    0b00000111, 0b01110111,
+    0b01111111, 0b10111111, 0b10111111, 0b01111111,
+};
+
+static void TestKerning()
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17);
+    CHECK(SharpMipDisplay::GetTextWidth("ABA", kKernedFont) == 5 - 2 + 10 - 1 + 5);
+    CHECK(SharpMipDisplay::GetTextWidth("AA", kKernedFont) == 10);
+    CHECK(SharpMipDisplay::GetTextWidth("BB", kKernedFont) == 20);
+
+    // Glyphs start at 13, 16 and 25
+    display.DrawLineOfTextAtPixel(13, 30, "ABA", kKernedFont, Display::Mode::kMix);
+    display.Flush();
+    panel.Receive();
+    const std::vector<int> black_columns[]{{13, 14, 15, 16, 17, 25, 26, 27, 28, 29}, {13, 17, 24, 25, 29}};
+    int wrong{0};
+    for (int y = 0; y < kHeight; ++y)
+    {
+        for (int x = 0; x < kWidth; ++x)
+        {
+            const bool black = (y == 30 || y == 31) && std::count(black_columns[y - 30].begin(), black_columns[y - 30].end(), x) > 0;
+            wrong += (panel.IsWhite(x, y) == black);
+        }
+    }
+    CHECK(wrong == 0);
+}
+
+int main()
+{
+    TestCompressedFont(kFont_8_10, kFont_8_10_Compressed.data());
+    TestCompressedFont(kFont_16_20, kFont_16_20_Compressed.data());
+    TestCompressedFont(kFont_24_30, kFont_24_30_Compressed.data());
+    TestCompressedFont(kFont_32_40, kFont_32_40_Compressed.data());
+    TestShiftedText(kFont_8_10, kFont_8_10_Compressed.data());
+    TestShiftedText(kFont_16_20, kFont_16_20_Compressed.data());
+    TestShiftedText(kFont_24_30, kFont_24_30_Compressed.data());
+    TestShiftedText(kFont_32_40, kFont_32_40_Compressed.data());
+    TestGlyphCache(kFont_8_10, kFont_8_10_Compressed.data());
+    TestGlyphCache(kFont_16_20, kFont_16_20_Compressed.data());
+    TestGlyphCache(kFont_24_30, kFont_24_30_Compressed.data());
+    TestGlyphCache(kFont_32_40, kFont_32_40_Compressed.data());
+    TestProportionalFont(kFont_8_10, kFont_8_10_Proportional.data());
+    TestProportionalFont(kFont_16_20, kFont_16_20_Proportional.data());
+    TestProportionalFont(kFont_24_30, kFont_24_30_Proportional.data());
+    TestProportionalFont(kFont_32_40, kFont_32_40_Proportional.data());
+    TestProportionalWidth();
+    TestKerning();
+    return TestResult();
+}
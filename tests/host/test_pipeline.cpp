@@ -0,0 +1,176 @@
+// Core 0 to core 1 handoff of the pipeline, built with -fsanitize=thread.
+// Core 1 is a std::thread, __sev() and __wfe() wake it like on the RP2040.
+
+#include <cstdio>
+#include <thread>
+#include "sharp_mip_display.h"
+#include "spsc_queue.h"
+#include "panel_model.h"
+#include "host_test.h"
+
+struct Item
+{
+    uint32_t sequence;
+    uint32_t payload[8];
+};
+
+static void TestSpscQueue()
+{
+    constexpr uint32_t kItems{100000};
+    SpscQueue<Item, 4> queue;
+    bool consumer_ok{true};
+
+    std::thread consumer([&queue, &consumer_ok]()
+    {
+        Item item;
+        for (uint32_t expected = 0; expected < kItems;)
+        {
+            if(!queue.TryPop(item))
+            {
+                std::this_thread::yield();
+                continue;
+            }
+            for (uint32_t word : item.payload)
+            {
+                consumer_ok = consumer_ok && word == item.sequence * 31;
+            }
+            consumer_ok = consumer_ok && item.sequence == expected;
+            ++expected;
+        }
+    });
+
+    for (uint32_t i = 0; i < kItems; ++i)
+    {
+        Item item;
+        item.sequence = i;
+        std::fill(item.payload, item.payload + 8, i * 31);
+        while(!queue.TryPush(item))
+        {
+            std::this_thread::yield();
+        }
+    }
+    consumer.join();
+    CHECK(consumer_ok);
+    CHECK(queue.IsEmpty());
+}
+
+// Expected frame k: everything white, except a black rectangle moving over the screen
+static bool IsFrameShown(const PanelModel& panel, int k)
+{
+    const int left{k % 100};
+    const int top{(k * 7) % 140};
+    for (int y = 0; y < 168; ++y)
+    {
+        for (int x = 0; x < 144; ++x)
+        {
+            const bool black = x >= left && x < left + 40 && y >= top && y < top + 20;
+            if(panel.IsWhite(x, y) == black)
+            {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+static void DrawFrame(SharpMipDisplay& display, int k)
+{
+    display.ClearRect(0, 0, 144, 168);
+    display.FillRect(k % 100, (k * 7) % 140, 40, 20);
+}
+
+static void TestPipelineHandoff(bool shadow_buffer)
+{
+    constexpr uint kCsPin{17};
+    StubClearRecords();
+    PanelModel panel(144, 168, kCsPin);
+    SharpMipDisplay* display = new SharpMipDisplay(144, 168, spi1, kCsPin);
+    display->EnableShadowBuffer(shadow_buffer);
+    display->EnableDoubleBuffering(true);
+    display->EnablePipeline();
+
+    // Core 0 draws the next frame into the back buffer while core 1 sends the previous one
+    for (int k = 0; k < 300; ++k)
+    {
+        DrawFrame(*display, k);
+        display->Present();
+        if(k % 16 == 0)
+        {
+            display->ToggleVCOM();
+        }
+        if(k % 50 == 49)
+        {
+            display->WaitIdle();
+            CHECK(!display->IsBusy());
+            panel.Receive();
+            CHECK(IsFrameShown(panel, k));
+        }
+    }
+
+    // Frames posted back to back, without waiting for the previous one
+    display->BeginFrame();
+    DrawFrame(*display, 1000);
+    display->Present();
+    display->EndFrame();
+    display->RefreshScreen(0, 168);
+    display->WaitIdle();
+    panel.Receive();
+    CHECK(IsFrameShown(panel, 1000));
+    CHECK(panel.Error().empty());
+    CHECK(StubWritesWithoutCs() == 0);
+
+    // The destructor resets core 1 and joins its thread
+    delete display;
+}
+
+// With the pipeline the timer interrupt only requests the VCOM command, core 1 sends it
+static void TestVcomTimer()
+{
+    constexpr uint kCsPin{17};
+    SharpMipDisplay* display = new SharpMipDisplay(144, 168, spi1, kCsPin);
+    display->EnablePipeline();
+    display->EnableVcomTimer(500);
+    display->WaitIdle();
+    StubClearRecords();
+
+    // Ticks without transactions in between send the command every time, with alternating VCOM bits
+    for (int tick = 0; tick < 4; ++tick)
+    {
+        CHECK(StubFireRepeatingTimer());
+        display->WaitIdle();
+    }
+    const std::vector<StubTransaction>& transactions = StubTransactions();
+    CHECK(transactions.size() == 4);
+    for (size_t i = 0; i < transactions.size(); ++i)
+    {
+        CHECK(transactions[i].on_core1);
+        CHECK(transactions[i].data.size() == 2 && transactions[i].data[1] == 0);
+        if(i > 0)
+        {
+            CHECK((transactions[i].data[0] ^ transactions[i - 1].data[0]) == 0b01000000);
+        }
+    }
+
+    // A refresh toggles VCOM, so the next tick is skipped
+    display->FillRect(0, 0, 10, 10);
+    display->Flush();
+    display->WaitIdle();
+    CHECK(StubFireRepeatingTimer());
+    display->WaitIdle();
+    CHECK(transactions.size() == 5);
+    CHECK(StubFireRepeatingTimer());
+    display->WaitIdle();
+    CHECK(transactions.size() == 6 && transactions.back().data.size() == 2);
+    CHECK(StubWritesWithoutCs() == 0);
+
+    delete display;
+}
+
+int main()
+{
+    TestSpscQueue();
+    TestPipelineHandoff(false);
+    TestPipelineHandoff(true);
+    TestVcomTimer();
+    return TestResult();
+}
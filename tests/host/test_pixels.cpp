@@ -0,0 +1,113 @@
+// Bit order of SetPixel() and ResetPixel(): the MSB of a byte is the leftmost pixel, the same as in fonts and on the panel
+
+#include "sharp_mip_display.h"
+#include "fonts/font_8x10.h"
+#include "fonts/font_16x20.h"
+#include "panel_model.h"
+#include "host_test.h"
+
+static constexpr uint16_t kWidth{144};
+static constexpr uint16_t kHeight{168};
+
+static int CountBlack(const PanelModel& panel)
+{
+    int black{0};
+    for (int y = 0; y < kHeight; ++y)
+    {
+        for (int x = 0; x < kWidth; ++x)
+        {
+            black += !panel.IsWhite(x, y);
+        }
+    }
+    return black;
+}
+
+static void TestSinglePixels()
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17);
+    for (uint16_t x = 0; x < 24; ++x)
+    {
+        display.SetPixel(x, 7);
+        display.Flush();
+        panel.Receive();
+        CHECK(!panel.IsWhite(x, 7));
+        CHECK(CountBlack(panel) == 1);
+
+        display.ResetPixel(x, 7);
+        display.Flush();
+        panel.Receive();
+        CHECK(CountBlack(panel) == 0);
+    }
+}
+
+// Text at pixel 8 + shift is text at byte 1 moved by shift pixels, and ResetPixel() erases exactly its black pixels
+static void TestPixelsMatchText(const uint8_t font[])
+{
+    StubClearRecords();
+    PanelModel aligned_panel(kWidth, kHeight, 17);
+    PanelModel shifted_panel(kWidth, kHeight, 18);
+    SharpMipDisplay aligned(kWidth, kHeight, spi1, 17);
+    SharpMipDisplay shifted(kWidth, kHeight, spi1, 18);
+    aligned.DrawLineOfText(1, 5, "Ag0", font, Display::Mode::kMix);
+    aligned.Flush();
+    aligned_panel.Receive();
+    CHECK(CountBlack(aligned_panel) > 0);
+
+    for (uint16_t shift = 1; shift < 8; ++shift)
+    {
+        shifted.ClearRect(0, 0, kWidth, kHeight);
+        shifted.DrawLineOfTextAtPixel(8 + shift, 5, "Ag0", font, Display::Mode::kMix);
+        shifted.Flush();
+        shifted_panel.Receive();
+        bool same{true};
+        for (int y = 0; y < kHeight; ++y)
+        {
+            for (int x = 0; x + shift < kWidth; ++x)
+            {
+                same = same && aligned_panel.IsWhite(x, y) == shifted_panel.IsWhite(x + shift, y);
+            }
+        }
+        CHECK(same);
+    }
+
+    for (int y = 0; y < kHeight; ++y)
+    {
+        for (int x = 0; x < kWidth; ++x)
+        {
+            if(!aligned_panel.IsWhite(x, y))
+            {
+                aligned.ResetPixel(x, y);
+            }
+        }
+    }
+    aligned.Flush();
+    aligned_panel.Receive();
+    CHECK(CountBlack(aligned_panel) == 0);
+}
+
+// Text which starts right of the screen draws nothing, on the last row it would read past the end of the buffer
+static void TestTextRightOfScreen()
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17);
+    for (uint16_t x = kWidth; x < kWidth + 24; ++x)
+    {
+        display.DrawLineOfTextAtPixel(x, kHeight - 1, "Ag0", kFont_16_20, Display::Mode::kReplace);
+        display.DrawLineOfTextAtPixel(x, kHeight - 1, "Ag0", kFont_8_10, Display::Mode::kMix);
+    }
+    display.Flush();
+    panel.Receive();
+    CHECK(CountBlack(panel) == 0);
+}
+
+int main()
+{
+    TestSinglePixels();
+    TestTextRightOfScreen();
+    TestPixelsMatchText(kFont_8_10);
+    TestPixelsMatchText(kFont_16_20);
+    return TestResult();
+}
@@ -0,0 +1,65 @@
+// FillRect(), ClearRect() and InvertRect() against a per-pixel reference, in both buffer layouts
+
+#include <cstdlib>
+#include "sharp_mip_display.h"
+#include "panel_model.h"
+#include "reference_screen.h"
+#include "host_test.h"
+
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+
+static void TestRects(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    ReferenceScreen reference(kWidth, kHeight);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17, layout);
+    std::srand(1);
+    for (int i = 0; i < 3000; ++i)
+    {
+        // Mostly narrow rects, which start and end inside one word, some of them wider than the screen
+        uint16_t x = std::rand() % 460;
+        uint16_t y = std::rand() % 260;
+        uint16_t width = std::rand() % ((i % 3 != 0) ? 40 : 460);
+        uint16_t height = std::rand() % 30;
+        if(i % 50 == 0)
+        {
+            x = 0;
+            width = kWidth;
+        }
+        const SharpMipDisplay::PixelOp op = static_cast<SharpMipDisplay::PixelOp>(std::rand() % 3);
+
+        SharpMipDisplay::LineRange range;
+        switch (op)
+        {
+        case SharpMipDisplay::PixelOp::kSet:
+            range = display.FillRect(x, y, width, height);
+            break;
+        case SharpMipDisplay::PixelOp::kClear:
+            range = display.ClearRect(x, y, width, height);
+            break;
+        case SharpMipDisplay::PixelOp::kInvert:
+            range = display.InvertRect(x, y, width, height);
+            break;
+        }
+        for (int row = y; row < y + height; ++row)
+        {
+            for (int column = x; column < x + width; ++column)
+            {
+                reference.Apply(column, row, op);
+            }
+        }
+
+        const SharpMipDisplay::LineRange expected = reference.DirtyRange();
+        CHECK(range.start == expected.start && range.end == expected.end);
+        CHECK(reference.FlushMatches(display, panel));
+    }
+}
+
+int main()
+{
+    TestRects(SharpMipDisplay::BufferLayout::kPacked);
+    TestRects(SharpMipDisplay::BufferLayout::kWire);
+    return TestResult();
+}
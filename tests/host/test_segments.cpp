@@ -0,0 +1,121 @@
+// Vertical and horizontal segments and full lines against a per-pixel reference, in both buffer layouts
+
+#include <cstdlib>
+#include <vector>
+#include "sharp_mip_display.h"
+#include "panel_model.h"
+#include "reference_screen.h"
+#include "host_test.h"
+
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+
+static void TestVerticalSegments(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    ReferenceScreen reference(kWidth, kHeight);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17, layout);
+    std::srand(5);
+    for (int i = 0; i < 3000; ++i)
+    {
+        const SharpMipDisplay::PixelOp op = static_cast<SharpMipDisplay::PixelOp>(std::rand() % 3);
+        const uint16_t y0 = std::rand() % 300;
+        const uint16_t y1 = std::rand() % 300;
+        // Every other call has columns close to each other, so several of them share a byte, and some are given twice
+        std::vector<uint16_t> columns(std::rand() % 40);
+        for (uint16_t& column : columns)
+        {
+            column = std::rand() % ((i % 2 != 0) ? 420 : 40);
+        }
+
+        SharpMipDisplay::LineRange range;
+        if(i % 3 == 0 && !columns.empty())
+        {
+            columns.resize(1);
+            range = display.DrawVerticalSegment(columns[0], y0, y1, op);
+        }
+        else
+        {
+            range = display.DrawVerticalSegments(columns.data(), columns.size(), y0, y1, op);
+        }
+        for (uint16_t column : columns)
+        {
+            for (int row = std::min(y0, y1); row <= std::max(y0, y1); ++row)
+            {
+                reference.Apply(column, row, op);
+            }
+        }
+
+        const SharpMipDisplay::LineRange expected = reference.DirtyRange();
+        CHECK(range.start == expected.start && range.end == expected.end);
+        CHECK(reference.FlushMatches(display, panel));
+    }
+
+    display.DrawVerticalLine(13);
+    display.DrawVerticalLine(kWidth);
+    for (int row = 0; row < kHeight; ++row)
+    {
+        reference.Apply(13, row, SharpMipDisplay::PixelOp::kSet);
+    }
+    CHECK(reference.FlushMatches(display, panel));
+}
+
+// Only rows of the segments are dirty, so FlushMatches() also checks that rows between them are not sent
+static void TestHorizontalSegments(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    ReferenceScreen reference(kWidth, kHeight);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17, layout);
+    std::srand(7);
+    for (int i = 0; i < 3000; ++i)
+    {
+        const SharpMipDisplay::PixelOp op = static_cast<SharpMipDisplay::PixelOp>(std::rand() % 3);
+        std::vector<SharpMipDisplay::HorizontalSegment> segments((i % 2 != 0) ? 1 : std::rand() % 20);
+        for (SharpMipDisplay::HorizontalSegment& segment : segments)
+        {
+            segment.x0 = std::rand() % 450;
+            segment.x1 = std::rand() % 450;
+            segment.y = std::rand() % 260;
+        }
+
+        SharpMipDisplay::LineRange range;
+        if(i % 2 != 0)
+        {
+            range = display.DrawHorizontalSegment(segments[0].x0, segments[0].x1, segments[0].y, op);
+        }
+        else
+        {
+            range = display.DrawHorizontalSegments(segments.data(), segments.size(), op);
+        }
+        for (const SharpMipDisplay::HorizontalSegment& segment : segments)
+        {
+            for (int column = std::min(segment.x0, segment.x1); column <= std::max(segment.x0, segment.x1); ++column)
+            {
+                reference.Apply(column, segment.y, op);
+            }
+        }
+
+        const SharpMipDisplay::LineRange expected = reference.DirtyRange();
+        CHECK(range.start == expected.start && range.end == expected.end);
+        CHECK(reference.FlushMatches(display, panel));
+    }
+
+    display.DrawHorizontalLine(17);
+    display.DrawHorizontalLine(kHeight);
+    for (int column = 0; column < kWidth; ++column)
+    {
+        reference.Apply(column, 17, SharpMipDisplay::PixelOp::kSet);
+    }
+    CHECK(reference.FlushMatches(display, panel));
+}
+
+int main()
+{
+    TestVerticalSegments(SharpMipDisplay::BufferLayout::kPacked);
+    TestVerticalSegments(SharpMipDisplay::BufferLayout::kWire);
+    TestHorizontalSegments(SharpMipDisplay::BufferLayout::kPacked);
+    TestHorizontalSegments(SharpMipDisplay::BufferLayout::kWire);
+    return TestResult();
+}
@@ -0,0 +1,265 @@
+// Lines, ellipses, arcs and rounded rects against per-pixel references, in both buffer layouts. Pixels on the exact border
+// of a thick line or an arc may go either way, all other pixels and the returned LineRange have to match.
+
+#include <cmath>
+#include <cstdlib>
+#include <vector>
+#include "sharp_mip_display.h"
+#include "panel_model.h"
+#include "host_test.h"
+
+static constexpr int kWidth{400};
+static constexpr int kHeight{240};
+
+enum class Expected{
+    kWhite,
+    kBlack,
+    kEither
+};
+
+// Draws the shape on a white screen and compares the panel with the reference, the range has to cover exactly the black rows
+template <typename Draw, typename Reference>
+static bool ShapeMatches(const char* name, SharpMipDisplay& display, PanelModel& panel, Draw draw, Reference reference)
+{
+    display.ClearRect(0, 0, kWidth, kHeight);
+    display.Flush();
+    const SharpMipDisplay::LineRange range = draw();
+    display.Flush();
+    panel.Receive();
+
+    int first_black_row{kHeight};
+    int end_of_black_rows{0};
+    for (int y = 0; y < kHeight; ++y)
+    {
+        for (int x = 0; x < kWidth; ++x)
+        {
+            const bool black = !panel.IsWhite(x, y);
+            if(black)
+            {
+                first_black_row = std::min(first_black_row, y);
+                end_of_black_rows = y + 1;
+            }
+            const Expected expected = reference(x, y);
+            if(expected != Expected::kEither && black != (expected == Expected::kBlack))
+            {
+                std::printf("%s: pixel %d %d is %s\n", name, x, y, black ? "black" : "white");
+                return false;
+            }
+        }
+    }
+    if(end_of_black_rows == 0)
+    {
+        first_black_row = 0;
+    }
+    if(range.start != first_black_row || range.end != end_of_black_rows)
+    {
+        std::printf("%s: range %d %d, black rows %d %d\n", name, range.start, range.end, first_black_row, end_of_black_rows);
+        return false;
+    }
+    return panel.Error().empty();
+}
+
+static Expected ExpectBlack(bool black)
+{
+    return black ? Expected::kBlack : Expected::kWhite;
+}
+
+// The ellipse contains pixels whose centers are within radius + 1/2 pixel of its center, on both axes
+static bool InEllipse(long dx, long dy, long radius_x, long radius_y)
+{
+    if(radius_y == 0)
+    {
+        return dy == 0 && std::labs(dx) <= radius_x;
+    }
+    const long rx = radius_x * radius_x + radius_x;
+    const long ry = radius_y * radius_y + radius_y;
+    if(dy * dy > ry || dx * dx > rx)
+    {
+        return false;
+    }
+    return dx * dx * ry + dy * dy * rx <= rx * ry;
+}
+
+// Pixels of the filled shape which have a neighbour outside of it
+template <typename Inside>
+static Expected Outline(int x, int y, Inside inside)
+{
+    if(!inside(x, y))
+    {
+        return Expected::kWhite;
+    }
+    return ExpectBlack(!(inside(x + 1, y) && inside(x - 1, y) && inside(x, y + 1) && inside(x, y - 1)));
+}
+
+// Whether the pixel is inside the clockwise sweep from start_angle to end_angle, pixels close to its edges may go either way
+static Expected InSweep(int dx, int dy, int start_angle, int end_angle)
+{
+    int sweep = ((end_angle - start_angle) % 360 + 360) % 360;
+    if(sweep == 0 && end_angle != start_angle)
+    {
+        sweep = 360;
+    }
+    if(sweep == 360)
+    {
+        return Expected::kBlack;
+    }
+    if(sweep == 0)
+    {
+        return Expected::kWhite;
+    }
+    if(dx == 0 && dy == 0)
+    {
+        return Expected::kEither;
+    }
+    const double angle = std::atan2(dy, dx) * 180 / M_PI;
+    const double relative = std::fmod(angle - start_angle + 720, 360);
+    const double distance = std::min({std::fabs(relative), std::fabs(relative - sweep), std::fabs(relative - 360)});
+    if(distance < 60.0 / std::max(1.0, std::hypot(dx, dy)))
+    {
+        return Expected::kEither;
+    }
+    return ExpectBlack(relative <= sweep);
+}
+
+static void TestShapes(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17, layout);
+    std::srand(3);
+    for (int i = 0; i < 40; ++i)
+    {
+        const int cx = std::rand() % 500 - 50;
+        const int cy = std::rand() % 340 - 50;
+        const int a = std::rand() % ((i % 4 != 0) ? 30 : 150);
+        const int b = std::rand() % ((i % 4 != 0) ? 30 : 150);
+
+        CHECK(ShapeMatches("FillEllipse", display, panel, [&]{ return display.FillEllipse(cx, cy, a, b); },
+                           [&](int x, int y){ return ExpectBlack(InEllipse(x - cx, y - cy, a, b)); }));
+        CHECK(ShapeMatches("DrawEllipse", display, panel, [&]{ return display.DrawEllipse(cx, cy, a, b); },
+                           [&](int x, int y){ return Outline(x, y, [&](int px, int py){ return InEllipse(px - cx, py - cy, a, b); }); }));
+
+        const int thickness = 1 + std::rand() % 8;
+        const int start_angle = std::rand() % 360;
+        const int end_angle = std::rand() % 400;
+        CHECK(ShapeMatches("DrawArc", display, panel, [&]{ return display.DrawArc(cx, cy, a, start_angle, end_angle, thickness); },
+                           [&](int x, int y){
+                               const int dx = x - cx;
+                               const int dy = y - cy;
+                               if(!InEllipse(dx, dy, a, a) || (a >= thickness && InEllipse(dx, dy, a - thickness, a - thickness)))
+                               {
+                                   return Expected::kWhite;
+                               }
+                               return InSweep(dx, dy, start_angle, end_angle);
+                           }));
+        CHECK(ShapeMatches("FillArc", display, panel, [&]{ return display.FillArc(cx, cy, a, start_angle, end_angle); },
+                           [&](int x, int y){
+                               const int dx = x - cx;
+                               const int dy = y - cy;
+                               return InEllipse(dx, dy, a, a) ? InSweep(dx, dy, start_angle, end_angle) : Expected::kWhite;
+                           }));
+
+        const int rx = std::rand() % 450 - 30;
+        const int ry = std::rand() % 280 - 30;
+        const int width = std::rand() % 120;
+        const int height = std::rand() % 80;
+        const int radius = std::rand() % 30;
+        auto in_round_rect = [&](int x, int y)
+        {
+            if(width == 0 || height == 0 || x < rx || x >= rx + width || y < ry || y >= ry + height)
+            {
+                return false;
+            }
+            const int r = std::min(radius, (std::min(width, height) - 1) / 2);
+            const int corner_x = std::min(std::max(x, rx + r), rx + width - 1 - r);
+            const int corner_y = std::min(std::max(y, ry + r), ry + height - 1 - r);
+            return InEllipse(x - corner_x, y - corner_y, r, r);
+        };
+        CHECK(ShapeMatches("FillRoundRect", display, panel, [&]{ return display.FillRoundRect(rx, ry, width, height, radius); },
+                           [&](int x, int y){ return ExpectBlack(in_round_rect(x, y)); }));
+        CHECK(ShapeMatches("DrawRoundRect", display, panel, [&]{ return display.DrawRoundRect(rx, ry, width, height, radius); },
+                           [&](int x, int y){ return Outline(x, y, in_round_rect); }));
+
+        // Thin lines are the textbook Bresenham line drawn from the upper end
+        const int x0 = std::rand() % 500 - 50;
+        const int y0 = std::rand() % 340 - 50;
+        const int x1 = std::rand() % 500 - 50;
+        const int y1 = std::rand() % 340 - 50;
+        std::vector<bool> line(kWidth * kHeight, false);
+        {
+            int x = (y0 <= y1) ? x0 : x1;
+            int y = (y0 <= y1) ? y0 : y1;
+            const int end_x = (y0 <= y1) ? x1 : x0;
+            const int end_y = (y0 <= y1) ? y1 : y0;
+            const int dx = std::abs(end_x - x);
+            const int dy = -(end_y - y);
+            const int step_x = (x < end_x) ? 1 : -1;
+            int error = dx + dy;
+            while (true)
+            {
+                if(x >= 0 && x < kWidth && y >= 0 && y < kHeight)
+                {
+                    line[y * kWidth + x] = true;
+                }
+                if(x == end_x && y == end_y)
+                {
+                    break;
+                }
+                const int doubled_error = 2 * error;
+                if(doubled_error >= dy)
+                {
+                    error += dy;
+                    x += step_x;
+                }
+                if(doubled_error <= dx)
+                {
+                    error += dx;
+                    ++y;
+                }
+            }
+        }
+        CHECK(ShapeMatches("DrawLine", display, panel, [&]{ return display.DrawLine(x0, y0, x1, y1); },
+                           [&](int x, int y){ return ExpectBlack(line[y * kWidth + x]); }));
+
+        // Thick lines are a rectangle around the line, which extends half a pixel past both ends
+        const int line_thickness = 2 + std::rand() % 10;
+        const double length = std::hypot(x1 - x0, y1 - y0);
+        const double ux = (length > 0) ? (x1 - x0) / length : 1;
+        const double uy = (length > 0) ? (y1 - y0) / length : 0;
+        CHECK(ShapeMatches("thick DrawLine", display, panel, [&]{ return display.DrawLine(x0, y0, x1, y1, line_thickness); },
+                           [&](int x, int y){
+                               const double along = (x - x0) * ux + (y - y0) * uy;
+                               const double across = -(x - x0) * uy + (y - y0) * ux;
+                               const double margin = std::min({along + 0.5, length + 0.5 - along,
+                                                               line_thickness / 2.0 - std::fabs(across)});
+                               return (std::fabs(margin) < 0.15) ? Expected::kEither : ExpectBlack(margin > 0);
+                           }));
+
+        // Drawing twice with PixelOp::kInvert restores the screen, every pixel of a shape is changed once
+        display.ClearRect(0, 0, kWidth, kHeight);
+        display.FillRect(0, 0, kWidth / 2, kHeight);
+        display.Flush();
+        panel.Receive();
+        std::vector<uint8_t> before(panel.Row(0), panel.Row(0) + kWidth / 8 * kHeight);
+        for (int repeat = 0; repeat < 2; ++repeat)
+        {
+            display.DrawEllipse(cx, cy, a, b, SharpMipDisplay::PixelOp::kInvert);
+            display.FillEllipse(cx, cy, b, a, SharpMipDisplay::PixelOp::kInvert);
+            display.DrawArc(cx, cy, a, start_angle, end_angle, thickness, SharpMipDisplay::PixelOp::kInvert);
+            display.FillArc(cx, cy, b, start_angle, end_angle, SharpMipDisplay::PixelOp::kInvert);
+            display.DrawRoundRect(rx, ry, width, height, radius, SharpMipDisplay::PixelOp::kInvert);
+            display.DrawLine(x0, y0, x1, y1, 1, SharpMipDisplay::PixelOp::kInvert);
+            display.DrawLine(x0, y0, x1, y1, line_thickness, SharpMipDisplay::PixelOp::kInvert);
+        }
+        display.Flush();
+        panel.Receive();
+        CHECK(std::equal(before.begin(), before.end(), panel.Row(0)));
+    }
+}
+
+int main()
+{
+    TestShapes(SharpMipDisplay::BufferLayout::kPacked);
+    TestShapes(SharpMipDisplay::BufferLayout::kWire);
+    return TestResult();
+}
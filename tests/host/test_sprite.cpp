@@ -0,0 +1,122 @@
+// DrawSprite() and HideSprite() against a per-pixel reference, in both buffer layouts: moving a sprite restores its old
+// background, changes only rows of its old and new position, and hiding it restores the screen.
+
+#include <cstdlib>
+#include <vector>
+#include "sharp_mip_display.h"
+#include "sprite.h"
+#include "panel_model.h"
+#include "reference_screen.h"
+#include "host_test.h"
+
+static constexpr uint16_t kWidth{400};
+static constexpr uint16_t kHeight{240};
+
+static bool BitmapIsWhite(const std::vector<uint8_t>& bitmap, uint16_t stride, int i, int j)
+{
+    return (bitmap[j * stride + i / 8] >> (7 - i % 8)) & 1;
+}
+
+static void TestSprites(SharpMipDisplay::BufferLayout layout)
+{
+    StubClearRecords();
+    PanelModel panel(kWidth, kHeight, 17);
+    ReferenceScreen reference(kWidth, kHeight);
+    SharpMipDisplay display(kWidth, kHeight, spi1, 17, layout);
+    std::srand(11);
+
+    // Random background, the reference keeps a copy of it to restore pixels below the sprite
+    std::vector<uint8_t> background(kWidth / 8 * kHeight);
+    for (uint8_t& pixels : background)
+    {
+        pixels = std::rand();
+    }
+    display.BlitBitmap(0, 0, background.data(), kWidth, kHeight, kWidth / 8);
+    for (int row = 0; row < kHeight; ++row)
+    {
+        for (int column = 0; column < kWidth; ++column)
+        {
+            reference.Put(column, row, BitmapIsWhite(background, kWidth / 8, column, row));
+        }
+    }
+    CHECK(reference.FlushMatches(display, panel));
+
+    for (int s = 0; s < 100; ++s)
+    {
+        const uint16_t width = 1 + std::rand() % 40;
+        const uint16_t height = 1 + std::rand() % 30;
+        const uint16_t stride = (width + 7) / 8 + std::rand() % 2;
+        std::vector<uint8_t> image(stride * height);
+        std::vector<uint8_t> mask(stride * height);
+        for (size_t i = 0; i < image.size(); ++i)
+        {
+            image[i] = std::rand();
+            mask[i] = std::rand();
+        }
+        Sprite sprite(image.data(), mask.data(), width, height, stride);
+        CHECK(!sprite.IsVisible());
+
+        auto restore_background = [&]()
+        {
+            for (int j = 0; j < height; ++j)
+            {
+                for (int i = 0; i < width; ++i)
+                {
+                    const int column = sprite.GetX() + i;
+                    const int row = sprite.GetY() + j;
+                    if(column >= 0 && column < kWidth && row >= 0 && row < kHeight)
+                    {
+                        reference.Put(column, row, BitmapIsWhite(background, kWidth / 8, column, row));
+                    }
+                }
+            }
+        };
+
+        for (int move = 0; move < 20; ++move)
+        {
+            const int16_t x = std::rand() % 480 - 60;
+            const int16_t y = std::rand() % 300 - 40;
+            if(sprite.IsVisible())
+            {
+                restore_background();
+            }
+            const SharpMipDisplay::LineRange range = display.DrawSprite(sprite, x, y);
+            CHECK(sprite.IsVisible() && sprite.GetX() == x && sprite.GetY() == y);
+
+            // Pixels of the mask show the image, the others are transparent
+            for (int j = 0; j < height; ++j)
+            {
+                for (int i = 0; i < width; ++i)
+                {
+                    const int column = x + i;
+                    const int row = y + j;
+                    if(column >= 0 && column < kWidth && row >= 0 && row < kHeight)
+                    {
+                        const bool white = BitmapIsWhite(mask, stride, i, j) ? BitmapIsWhite(image, stride, i, j)
+                                                                              : BitmapIsWhite(background, kWidth / 8, column, row);
+                        reference.Put(column, row, white);
+                    }
+                }
+            }
+
+            const SharpMipDisplay::LineRange expected = reference.DirtyRange();
+            CHECK(range.start == expected.start && range.end == expected.end);
+            CHECK(reference.FlushMatches(display, panel));
+        }
+
+        restore_background();
+        const SharpMipDisplay::LineRange range = display.HideSprite(sprite);
+        const SharpMipDisplay::LineRange expected = reference.DirtyRange();
+        CHECK(!sprite.IsVisible());
+        CHECK(range.start == expected.start && range.end == expected.end);
+        CHECK(reference.FlushMatches(display, panel));
+        CHECK(display.HideSprite(sprite).end == 0);
+    }
+}
+
+int main()
+{
+    TestSprites(SharpMipDisplay::BufferLayout::kPacked);
+    TestSprites(SharpMipDisplay::BufferLayout::kWire);
+    return TestResult();
+}
@@ -0,0 +1,133 @@
+// Chip select timing of every transaction against the profiles of sharp_mip_timing.h, measured with the mock clock
+
+#include <vector>
+#include "sharp_mip_display.h"
+#include "sharp_mip_timing.h"
+#include "host_stub.h"
+#include "host_test.h"
+
+static constexpr uint kCsPin{17};
+static constexpr uint32_t kSpiByteTimeUs{4};
+
+struct Profile
+{
+    const char* name;
+    SharpMipTiming timing;
+    uint16_t width;
+    uint16_t height;
+};
+
+// Checks the events of all transactions, from the first CS high to the last CS low
+static void CheckTiming(const Profile& profile, size_t expected_transactions)
+{
+    const std::vector<StubEvent>& events = StubEvents();
+    const SharpMipTiming& timing = profile.timing;
+    size_t transactions{0};
+    bool cs_high{false};
+    uint64_t cs_high_time{0};
+    uint64_t cs_low_time{0};
+    uint64_t spi_end_time{0};
+    bool first_write{false};
+    bool waited_while_low{false};
+    bool has_low_time{false};
+
+    for (const StubEvent& event : events)
+    {
+        if(event.type == StubEvent::Type::kPinHigh && event.value == kCsPin)
+        {
+            if(has_low_time)
+            {
+                // twSCSL is kept, but a panel which was low long enough is not delayed
+                const uint64_t low_width = event.time_us - cs_low_time;
+                CHECK(low_width >= timing.twSCSL);
+                if(waited_while_low)
+                {
+                    CHECK(low_width == timing.twSCSL);
+                }
+            }
+            cs_high = true;
+            cs_high_time = event.time_us;
+            first_write = true;
+            ++transactions;
+        }
+        else if(event.type == StubEvent::Type::kSpiWrite)
+        {
+            CHECK(cs_high);
+            if(first_write)
+            {
+                CHECK(event.time_us - cs_high_time == timing.tsSCS);
+                first_write = false;
+            }
+            spi_end_time = event.time_us + event.value * kSpiByteTimeUs;
+        }
+        else if(event.type == StubEvent::Type::kPinLow && event.value == kCsPin)
+        {
+            if(cs_high)
+            {
+                CHECK(event.time_us - spi_end_time == timing.thSCS);
+            }
+            cs_high = false;
+            cs_low_time = event.time_us;
+            has_low_time = true;
+            waited_while_low = false;
+        }
+        else if(event.type == StubEvent::Type::kBusyWait && !cs_high)
+        {
+            waited_while_low = true;
+        }
+    }
+    CHECK(!cs_high);
+    if(transactions != expected_transactions)
+    {
+        std::printf("%s: %zu transactions\n", profile.name, transactions);
+    }
+    CHECK(transactions == expected_transactions);
+}
+
+static void TestProfile(const Profile& profile)
+{
+    StubSetSpiByteTime(kSpiByteTimeUs);
+    StubClearRecords();
+    SharpMipDisplay display(profile.width, profile.height, spi1, kCsPin);
+    display.SetTiming(profile.timing);
+
+    // Transactions back to back, each one has to wait twSCSL after the previous one
+    display.FillRect(0, 0, 16, 16);
+    display.Flush();
+    display.RefreshScreen(0, profile.height);
+    display.ToggleVCOM();
+    display.ClearScreen();
+
+    // A panel idle for long is not delayed again
+    StubAdvanceTime(1000);
+    display.ToggleVCOM();
+    StubAdvanceTime(1000);
+    display.RefreshScreen(5, 6);
+
+    // Timer ticks do no SPI, they request the VCOM command. A refresh toggles VCOM for the request, the tick after it is skipped,
+    // ToggleVCOM() sends the command only for a request which is still pending
+    display.EnableVcomTimer(500);
+    StubFireRepeatingTimer();
+    display.RefreshScreen(0, 1);
+    display.ToggleVCOM();
+    StubFireRepeatingTimer();
+    StubFireRepeatingTimer();
+    display.ToggleVCOM();
+    display.ToggleVCOM();
+
+    CheckTiming(profile, 8);
+}
+
+int main()
+{
+    const Profile profiles[]{
+        {"LS013B7DH03", kTiming_LS013B7DH03, 128, 128},
+        {"LS013B7DH05", kTiming_LS013B7DH05, 144, 168},
+        {"LS027B7DH01", kTiming_LS027B7DH01, 400, 240},
+    };
+    for (const Profile& profile : profiles)
+    {
+        TestProfile(profile);
+    }
+    return TestResult();
+}
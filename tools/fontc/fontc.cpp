@@ -0,0 +1,640 @@
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdint.h>
+#include <algorithm>
+#include <fstream>
+#include <sstream>
+#include <string>
+#include <vector>
+
+#include "font_format.h"
+
+/*
+ * fontc - converts BDF bitmap fonts into font headers of the Sharp Memory display driver.
+ *
+ *  fontc [options] input.bdf
+ *   -o FILE               output header, stdout by default
+ *   --name NAME           name of the table, kFont by default
+ *   --guard GUARD         include guard, NAME_H by default
+ *   --format FORMAT       raw (default), compressed or proportional, see font_format.h
+ *   --range FIRST-LAST    characters in the table, decimal or 0x hex, 32-126 by default
+ *   --pad-left N          white columns added left of every glyph, also --pad-right, --pad-top and --pad-bottom
+ *   --invert              ink is 1 and background 0, only for raw tables
+ *   --kerning FILE        kerning pairs for the proportional format, lines "LEFT RIGHT ADJUSTMENT", characters
+ *                         as themselves or as decimal codes, e.g. "A V -2" or "84 111 -1"
+ */
+
+struct BdfGlyph
+{
+    int encoding{-1};
+    int advance{0};
+    int width{0};
+    int height{0};
+    int x_offset{0};
+    int y_offset{0};
+    std::vector<std::vector<bool>> ink;     // rows from top to bottom
+};
+
+struct BdfFont
+{
+    int width{0};
+    int height{0};
+    int x_offset{0};
+    int y_offset{0};
+    std::vector<BdfGlyph> glyphs;
+};
+
+enum class Format{
+    kRaw,
+    kCompressed,
+    kProportional
+};
+
+struct Options
+{
+    std::string input;
+    std::string output;
+    std::string name{"kFont"};
+    std::string guard;
+    Format format{Format::kRaw};
+    int first_char{0x20};
+    int last_char{0x7E};
+    int pad_left{0};
+    int pad_right{0};
+    int pad_top{0};
+    int pad_bottom{0};
+    bool invert{false};
+    std::string kerning;
+};
+
+struct KerningPair
+{
+    uint8_t left;
+    uint8_t right;
+    int8_t adjustment;
+};
+
+// Line of the generated table, bytes are printed in binary or hex, with an optional comment
+struct TableLine
+{
+    std::vector<uint8_t> bytes;
+    bool binary;
+    std::string comment;
+};
+
+// Glyph as it is stored in raw and proportional tables, 1 = white
+struct Bitmap
+{
+    int width_in_bytes{0};
+    int height{0};
+    std::vector<uint8_t> rows;
+};
+
+static bool ParseBdf(const std::string& path, BdfFont& font)
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        fprintf(stderr, "fontc: cannot open %s\n", path.c_str());
+        return false;
+    }
+
+    std::string line;
+    BdfGlyph glyph;
+    bool in_bitmap{false};
+    while(std::getline(file, line))
+    {
+        std::istringstream words(line);
+        std::string keyword;
+        words >> keyword;
+        if(in_bitmap)
+        {
+            if(keyword == "ENDCHAR")
+            {
+                in_bitmap = false;
+                font.glyphs.push_back(glyph);
+                continue;
+            }
+            // Every row is padded to whole bytes, leftmost pixel in the MSB
+            std::vector<bool> row(glyph.width, false);
+            for(int i = 0; i < glyph.width && static_cast<size_t>(i / 4) < keyword.size(); ++i)
+            {
+                int nibble = std::stoi(keyword.substr(i / 4, 1), nullptr, 16);
+                row[i] = (nibble >> (3 - i % 4)) & 1;
+            }
+            glyph.ink.push_back(row);
+        }
+        else if(keyword == "FONTBOUNDINGBOX")
+        {
+            words >> font.width >> font.height >> font.x_offset >> font.y_offset;
+        }
+        else if(keyword == "STARTCHAR")
+        {
+            glyph = BdfGlyph{};
+        }
+        else if(keyword == "ENCODING")
+        {
+            words >> glyph.encoding;
+        }
+        else if(keyword == "DWIDTH")
+        {
+            words >> glyph.advance;
+        }
+        else if(keyword == "BBX")
+        {
+            words >> glyph.width >> glyph.height >> glyph.x_offset >> glyph.y_offset;
+        }
+        else if(keyword == "BITMAP")
+        {
+            in_bitmap = true;
+        }
+    }
+
+    if(font.width <= 0 || font.height <= 0)
+    {
+        fprintf(stderr, "fontc: %s has no FONTBOUNDINGBOX\n", path.c_str());
+        return false;
+    }
+    return true;
+}
+
+static const BdfGlyph* FindGlyph(const BdfFont& font, int encoding)
+{
+    for(const auto& glyph : font.glyphs)
+    {
+        if(glyph.encoding == encoding)
+        {
+            return &glyph;
+        }
+    }
+    return nullptr;
+}
+
+static void ClearPixel(Bitmap& bitmap, int row, int column)
+{
+    bitmap.rows[row*bitmap.width_in_bytes + column / 8] &= ~(0b10000000 >> (column % 8));
+}
+
+// Draws the glyph into a bitmap of cell_width pixels, origin of the glyph is origin_column pixels from the left edge
+static Bitmap RenderGlyph(const BdfFont& font, const BdfGlyph* glyph, const Options& options, int cell_width, int origin_column)
+{
+    Bitmap bitmap;
+    bitmap.width_in_bytes = (cell_width + 7) / 8;
+    bitmap.height = font.height + options.pad_top + options.pad_bottom;
+    bitmap.rows.assign(bitmap.width_in_bytes * bitmap.height, 0b11111111);
+    if(glyph == nullptr)
+    {
+        return bitmap;
+    }
+
+    const int ascent = font.height + font.y_offset;
+    const int top = options.pad_top + ascent - (glyph->y_offset + glyph->height);
+    for(int j = 0; j < glyph->height && j < static_cast<int>(glyph->ink.size()); ++j)
+    {
+        for(int i = 0; i < glyph->width; ++i)
+        {
+            int row = top + j;
+            int column = origin_column + glyph->x_offset + i;
+            if(glyph->ink[j][i] && row >= 0 && row < bitmap.height && column >= 0 && column < cell_width)
+            {
+                ClearPixel(bitmap, row, column);
+            }
+        }
+    }
+    return bitmap;
+}
+
+static std::string CharComment(int character)
+{
+    char comment[32];
+    if(character > 0x20 && character < 0x7F && character != '\\')
+    {
+        snprintf(comment, sizeof(comment), "'%c' (%d)", character, character);
+    }
+    else
+    {
+        snprintf(comment, sizeof(comment), "(%d)", character);
+    }
+    return comment;
+}
+
+static void AddRows(std::vector<TableLine>& table, const Bitmap& bitmap, int row, int amount_of_rows)
+{
+    for(int j = row; j < row + amount_of_rows; ++j)
+    {
+        auto first = bitmap.rows.begin() + j*bitmap.width_in_bytes;
+        table.push_back(TableLine{std::vector<uint8_t>(first, first + bitmap.width_in_bytes), true, ""});
+    }
+}
+
+static bool EncodeRaw(const BdfFont& font, const Options& options, std::vector<TableLine>& table)
+{
+    const int cell_width = font.width + options.pad_left + options.pad_right;
+    const int height = font.height + options.pad_top + options.pad_bottom;
+    table.push_back(TableLine{{static_cast<uint8_t>((cell_width + 7) / 8), static_cast<uint8_t>(height)}, false, "width in BYTES, height"});
+    table.push_back(TableLine{{static_cast<uint8_t>(options.first_char)}, false, "first char"});
+    for(int c = options.first_char; c <= options.last_char; ++c)
+    {
+        Bitmap bitmap = RenderGlyph(font, FindGlyph(font, c), options, cell_width, options.pad_left - font.x_offset);
+        if(options.invert)
+        {
+            for(auto& pixels : bitmap.rows)
+            {
+                pixels = ~pixels;
+            }
+        }
+        table.push_back(TableLine{{}, false, CharComment(c)});
+        AddRows(table, bitmap, 0, bitmap.height);
+    }
+    return true;
+}
+
+static bool EncodeCompressed(const BdfFont& font, const Options& options, std::vector<TableLine>& table)
+{
+    const int cell_width = font.width + options.pad_left + options.pad_right;
+    const int width_in_bytes = (cell_width + 7) / 8;
+    const int height = font.height + options.pad_top + options.pad_bottom;
+    const int amount_of_chars = options.last_char - options.first_char + 1;
+    table.push_back(TableLine{{static_cast<uint8_t>(kCompressedFontFlag | width_in_bytes), static_cast<uint8_t>(height)}, false,
+                              "compressed, width in BYTES, height"});
+    table.push_back(TableLine{{static_cast<uint8_t>(options.first_char), static_cast<uint8_t>(amount_of_chars)}, false, "first char, amount of chars"});
+
+    std::vector<TableLine> glyphs;
+    size_t offset{0};
+    for(int c = options.first_char; c <= options.last_char; ++c)
+    {
+        Bitmap bitmap = RenderGlyph(font, FindGlyph(font, c), options, cell_width, options.pad_left - font.x_offset);
+        table.push_back(TableLine{{static_cast<uint8_t>(offset), static_cast<uint8_t>(offset >> 8)}, false, "offset of " + CharComment(c)});
+
+        // Store only rows which differ from the previous one
+        std::vector<uint8_t> row_bitmap((height + 7) / 8, 0);
+        std::vector<int> stored_rows;
+        std::vector<uint8_t> previous(width_in_bytes, 0b11111111);
+        for(int j = 0; j < height; ++j)
+        {
+            std::vector<uint8_t> row(bitmap.rows.begin() + j*width_in_bytes, bitmap.rows.begin() + (j + 1)*width_in_bytes);
+            if(row != previous)
+            {
+                row_bitmap[j / 8] |= 1 << (j % 8);
+                stored_rows.push_back(j);
+            }
+            previous = row;
+        }
+        glyphs.push_back(TableLine{row_bitmap, false, CharComment(c)});
+        for(int j : stored_rows)
+        {
+            AddRows(glyphs, bitmap, j, 1);
+        }
+        offset += row_bitmap.size() + stored_rows.size() * width_in_bytes;
+    }
+    if(offset > 0xFFFF)
+    {
+        fprintf(stderr, "fontc: glyphs take %zu bytes, the compressed format supports 65535\n", offset);
+        return false;
+    }
+    table.insert(table.end(), glyphs.begin(), glyphs.end());
+    return true;
+}
+
+static bool ReadKerning(const std::string& path, std::vector<KerningPair>& pairs)
+{
+    std::ifstream file(path);
+    if(!file)
+    {
+        fprintf(stderr, "fontc: cannot open %s\n", path.c_str());
+        return false;
+    }
+    auto character = [](const std::string& word) { return word.size() == 1 ? static_cast<uint8_t>(word[0]) : static_cast<uint8_t>(std::stoi(word, nullptr, 0)); };
+    std::string line;
+    while(std::getline(file, line))
+    {
+        std::istringstream words(line);
+        std::string left;
+        std::string right;
+        int adjustment{0};
+        if(!(words >> left) || left[0] == '#')
+        {
+            continue;
+        }
+        if(!(words >> right >> adjustment))
+        {
+            fprintf(stderr, "fontc: wrong kerning pair \"%s\"\n", line.c_str());
+            return false;
+        }
+        pairs.push_back(KerningPair{character(left), character(right), static_cast<int8_t>(adjustment)});
+    }
+    // The driver finds pairs with binary search
+    std::sort(pairs.begin(), pairs.end(), [](const KerningPair& a, const KerningPair& b) {
+        return a.left != b.left ? a.left < b.left : a.right < b.right;
+    });
+    return true;
+}
+
+static bool EncodeProportional(const BdfFont& font, const Options& options, std::vector<TableLine>& table)
+{
+    std::vector<KerningPair> pairs;
+    if(!options.kerning.empty() && !ReadKerning(options.kerning, pairs))
+    {
+        return false;
+    }
+    if(pairs.size() > 255)
+    {
+        fprintf(stderr, "fontc: %zu kerning pairs, the proportional format supports 255\n", pairs.size());
+        return false;
+    }
+
+    const int height = font.height + options.pad_top + options.pad_bottom;
+    const int amount_of_chars = options.last_char - options.first_char + 1;
+    std::vector<TableLine> entries;
+    std::vector<TableLine> glyphs;
+    size_t offset{0};
+    int max_width_in_bytes{1};
+    for(int c = options.first_char; c <= options.last_char; ++c)
+    {
+        const BdfGlyph* glyph = FindGlyph(font, c);
+        const int advance = (glyph != nullptr ? glyph->advance : 0) + options.pad_left + options.pad_right;
+        if(advance > 255)
+        {
+            fprintf(stderr, "fontc: advance of %s is %d, the proportional format supports 255\n", CharComment(c).c_str(), advance);
+            return false;
+        }
+        Bitmap bitmap = RenderGlyph(font, glyph, options, advance, options.pad_left);
+        max_width_in_bytes = std::max(max_width_in_bytes, bitmap.width_in_bytes);
+        entries.push_back(TableLine{{static_cast<uint8_t>(offset), static_cast<uint8_t>(offset >> 8), static_cast<uint8_t>(advance)}, false,
+                                    "offset and advance of " + CharComment(c)});
+        glyphs.push_back(TableLine{{}, false, CharComment(c)});
+        AddRows(glyphs, bitmap, 0, bitmap.height);
+        offset += bitmap.rows.size();
+    }
+    if(offset > 0xFFFF)
+    {
+        fprintf(stderr, "fontc: glyphs take %zu bytes, the proportional format supports 65535\n", offset);
+        return false;
+    }
+    if(max_width_in_bytes > kFontWidthMask)
+    {
+        fprintf(stderr, "fontc: glyphs are %d bytes wide, the proportional format supports %d\n", max_width_in_bytes, kFontWidthMask);
+        return false;
+    }
+
+    table.push_back(TableLine{{static_cast<uint8_t>(kProportionalFontFlag | max_width_in_bytes), static_cast<uint8_t>(height)}, false,
+                              "proportional, width of the widest glyph in BYTES, height"});
+    table.push_back(TableLine{{static_cast<uint8_t>(options.first_char), static_cast<uint8_t>(amount_of_chars), static_cast<uint8_t>(pairs.size())}, false,
+                              "first char, amount of chars, amount of kerning pairs"});
+    table.insert(table.end(), entries.begin(), entries.end());
+    for(const auto& pair : pairs)
+    {
+        table.push_back(TableLine{{pair.left, pair.right, static_cast<uint8_t>(pair.adjustment)}, false,
+                                  "kerning " + CharComment(pair.left) + " " + CharComment(pair.right)});
+    }
+    table.insert(table.end(), glyphs.begin(), glyphs.end());
+    return true;
+}
+
+static void WriteHeader(FILE* output, const Options& options, const BdfFont& font, const std::vector<TableLine>& table)
+{
+    static const char* kFormatNames[] = {"raw", "compressed", "proportional"};
+    fprintf(output, "#ifndef %s\n#define %s\n\n", options.guard.c_str(), options.guard.c_str());
+    fprintf(output, "#include <stdint.h>\n\n");
+    fprintf(output, "// Generated by fontc from %s\n", options.input.c_str());
+    fprintf(output, "// %s font, (%dpx + %dpx + %dpx) x (%dpx + %dpx + %dpx), characters %d-%d\n", kFormatNames[static_cast<int>(options.format)],
+            options.pad_left, font.width, options.pad_right, options.pad_top, font.height, options.pad_bottom, options.first_char, options.last_char);
+    fprintf(output, "constexpr uint8_t %s[] = {\n", options.name.c_str());
+
+    size_t remaining{0};
+    for(const auto& line : table)
+    {
+        remaining += line.bytes.size();
+    }
+    for(const auto& line : table)
+    {
+        if(line.bytes.empty())
+        {
+            fprintf(output, "\n    // %s\n", line.comment.c_str());
+            continue;
+        }
+        fprintf(output, "   ");
+        for(uint8_t byte : line.bytes)
+        {
+            --remaining;
+            if(line.binary)
+            {
+                fprintf(output, " 0b");
+                for(int bit = 7; bit >= 0; --bit)
+                {
+                    fputc('0' + ((byte >> bit) & 1), output);
+                }
+            }
+            else
+            {
+                fprintf(output, " 0x%02X", byte);
+            }
+            if(remaining > 0)
+            {
+                fputc(',', output);
+            }
+        }
+        if(!line.comment.empty())
+        {
+            fprintf(output, "   // %s", line.comment.c_str());
+        }
+        fputc('\n', output);
+    }
+    fprintf(output, "};\n\n#endif // %s\n", options.guard.c_str());
+}
+
+static void PrintUsage()
+{
+    fprintf(stderr, "usage: fontc [-o FILE] [--name NAME] [--guard GUARD] [--format raw|compressed|proportional] [--range FIRST-LAST]\n"
+                    "             [--pad-left N] [--pad-right N] [--pad-top N] [--pad-bottom N] [--invert] [--kerning FILE] input.bdf\n");
+}
+
+static bool ParseOptions(int argc, char* argv[], Options& options)
+{
+    for(int i = 1; i < argc; ++i)
+    {
+        std::string argument = argv[i];
+        bool has_value = i + 1 < argc;
+        if(argument == "--invert")
+        {
+            options.invert = true;
+        }
+        else if(argument[0] != '-')
+        {
+            options.input = argument;
+        }
+        else if(!has_value)
+        {
+            fprintf(stderr, "fontc: %s needs a value\n", argument.c_str());
+            return false;
+        }
+        else
+        {
+            std::string value = argv[++i];
+            if(argument == "-o")
+            {
+                options.output = value;
+            }
+            else if(argument == "--name")
+            {
+                options.name = value;
+            }
+            else if(argument == "--guard")
+            {
+                options.guard = value;
+            }
+            else if(argument == "--format")
+            {
+                if(value == "raw")
+                {
+                    options.format = Format::kRaw;
+                }
+                else if(value == "compressed")
+                {
+                    options.format = Format::kCompressed;
+                }
+                else if(value == "proportional")
+                {
+                    options.format = Format::kProportional;
+                }
+                else
+                {
+                    fprintf(stderr, "fontc: unknown format %s\n", value.c_str());
+                    return false;
+                }
+            }
+            else if(argument == "--range")
+            {
+                size_t dash = value.find('-', 1);
+                if(dash == std::string::npos)
+                {
+                    fprintf(stderr, "fontc: range has to be FIRST-LAST\n");
+                    return false;
+                }
+                options.first_char = std::stoi(value.substr(0, dash), nullptr, 0);
+                options.last_char = std::stoi(value.substr(dash + 1), nullptr, 0);
+            }
+            else if(argument == "--pad-left")
+            {
+                options.pad_left = std::stoi(value);
+            }
+            else if(argument == "--pad-right")
+            {
+                options.pad_right = std::stoi(value);
+            }
+            else if(argument == "--pad-top")
+            {
+                options.pad_top = std::stoi(value);
+            }
+            else if(argument == "--pad-bottom")
+            {
+                options.pad_bottom = std::stoi(value);
+            }
+            else if(argument == "--kerning")
+            {
+                options.kerning = value;
+            }
+            else
+            {
+                fprintf(stderr, "fontc: unknown option %s\n", argument.c_str());
+                return false;
+            }
+        }
+    }
+
+    if(options.input.empty())
+    {
+        return false;
+    }
+    if(options.first_char < 0 || options.last_char > 255 || options.first_char > options.last_char)
+    {
+        fprintf(stderr, "fontc: range has to be within 0-255\n");
+        return false;
+    }
+    if(options.pad_left < 0 || options.pad_right < 0 || options.pad_top < 0 || options.pad_bottom < 0)
+    {
+        fprintf(stderr, "fontc: padding cannot be negative\n");
+        return false;
+    }
+    if(options.format != Format::kRaw && options.last_char - options.first_char + 1 > 255)
+    {
+        fprintf(stderr, "fontc: the compressed and proportional formats support 255 characters\n");
+        return false;
+    }
+    if(options.invert && options.format != Format::kRaw)
+    {
+        // Compressed and proportional glyphs are merged with the screen buffer assuming 1 = white
+        fprintf(stderr, "fontc: --invert is supported only for the raw format\n");
+        return false;
+    }
+    if(!options.kerning.empty() && options.format != Format::kProportional)
+    {
+        fprintf(stderr, "fontc: --kerning is supported only for the proportional format\n");
+        return false;
+    }
+    if(options.guard.empty())
+    {
+        options.guard = options.name + "_H";
+    }
+    return true;
+}
+
+int main(int argc, char* argv[])
+{
+    Options options;
+    if(!ParseOptions(argc, argv, options))
+    {
+        PrintUsage();
+        return 1;
+    }
+
+    BdfFont font;
+    if(!ParseBdf(options.input, font))
+    {
+        return 1;
+    }
+
+    const int cell_width = font.width + options.pad_left + options.pad_right;
+    const int height = font.height + options.pad_top + options.pad_bottom;
+    if(height > 255 || (options.format != Format::kProportional && (cell_width + 7) / 8 > kFontWidthMask))
+    {
+        fprintf(stderr, "fontc: glyphs of %dx%d px do not fit into the font header\n", cell_width, height);
+        return 1;
+    }
+
+    std::vector<TableLine> table;
+    bool encoded{false};
+    switch(options.format)
+    {
+    case Format::kRaw:
+        encoded = EncodeRaw(font, options, table);
+        break;
+    case Format::kCompressed:
+        encoded = EncodeCompressed(font, options, table);
+        break;
+    case Format::kProportional:
+        encoded = EncodeProportional(font, options, table);
+        break;
+    }
+    if(!encoded)
+    {
+        return 1;
+    }
+
+    FILE* output = stdout;
+    if(!options.output.empty())
+    {
+        output = fopen(options.output.c_str(), "w");
+        if(output == nullptr)
+        {
+            fprintf(stderr, "fontc: cannot write %s\n", options.output.c_str());
+            return 1;
+        }
+    }
+    WriteHeader(output, options, font, table);
+    if(output != stdout)
+    {
+        fclose(output);
+    }
+    return 0;
+}